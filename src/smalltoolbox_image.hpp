@@ -1,10 +1,16 @@
 #ifndef SMALLTOOLBOX_IMAGE_H
 #define SMALLTOOLBOX_IMAGE_H
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <cmath>
 #include <locale>
+#include <ostream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 
@@ -185,10 +191,12 @@ public:
     // strokeWidth   : Line width,
     // fillOpacity   : Fill opacity or alpha value from 0 to 255.
     // strokeOpacity : Stroke opacity or alpha value from 0 to 255.
+    // className     : CSS class used instead of the inline style (see StyleRegistry).
     struct Style {
         std::string name{"Shape"}, fill{Color::WHITE}, stroke{Color::BLACK};
         double strokeWidth{1.0};
         double fillOpacity{255.0}, strokeOpacity{255.0}; // 0.0 = 0%; 255 = 1.0 = 100%
+        std::string className;
 
         Style() = default;
 
@@ -224,6 +232,24 @@ public:
             :  Style(name,  fill, stroke, strokeWidth, fillOpacity, strokeOpacity), points(points) {}
     };
 
+    // Polygon and Polyline with integer coordinates.
+    // points   : Points vector (x,y).
+    // decimals : fixed point, the coordinates are multiples of 10^-decimals.
+    struct IntegerShape : Style {
+        std::vector<std::array<long long, 2> > points;
+        int decimals{0};
+
+        IntegerShape() = default;
+
+        IntegerShape(const std::string &name, const std::string &fill, const std::string &stroke,
+                     const double &strokeWidth, const std::vector<std::array<long long, 2> > &points)
+            :  Style(name, fill, stroke, strokeWidth), points(points) {}
+        IntegerShape(const std::string &name, const std::string &fill, const std::string &stroke,
+                     const double &strokeWidth, const double &fillOpacity, const double &strokeOpacity,
+                     const std::vector<std::array<long long, 2> > &points)
+            :  Style(name,  fill, stroke, strokeWidth, fillOpacity, strokeOpacity), points(points) {}
+    };
+
     // Circle and Ellipse.
     // center           : Central point, (x,y)
     // horizontalRadius : Horizontal radius of circle, rx
@@ -254,6 +280,244 @@ public:
             center(center), horizontalRadius(horizontalRadius), verticalRadius(verticalRadius) {}
     };
 
+    // Elliptical arcs.
+    // points           : Start point followed by the end point of each arc, (x,y)
+    // horizontalRadius : Horizontal radius, rx
+    // verticalRadius   : Vertical radius, ry
+    // rotation         : Rotation of the x-axis in degrees
+    // largeArc, sweep  : Arc flags
+    struct ArcShape : Style {
+        std::vector<std::array<double, 2> > points;
+        double horizontalRadius{1};
+        double verticalRadius{1};
+        double rotation{0};
+        bool largeArc{false};
+        bool sweep{true};
+
+        ArcShape() = default;
+
+        ArcShape(const std::string &name, const std::string &fill, const std::string &stroke,
+                 const double &strokeWidth, const std::vector<std::array<double, 2> > &points,
+                 const double &horizontalRadius, const double &verticalRadius, const double &rotation,
+                 bool largeArc, bool sweep)
+            :  Style(name, fill, stroke, strokeWidth), points(points), horizontalRadius(horizontalRadius),
+            verticalRadius(verticalRadius), rotation(rotation), largeArc(largeArc), sweep(sweep) {}
+    };
+
+    // Number formatting.
+    // precision : decimal places, < 0 uses the shortest text that reads back the same value,
+    // trim      : removes trailing zeros and the decimal point,
+    // compact   : polygons and polylines as compact path data (see path).
+    // Passed to each function that writes numbers, the default is the historical output.
+    struct Format {
+        int precision;
+        bool trim;
+        bool compact;
+
+        // Constructor rather than member initializers : Format() is a default argument in SVG.
+        constexpr Format(int precision = 6, bool trim = true, bool compact = false)
+            : precision(precision), trim(trim), compact(compact) {}
+
+        auto operator==(const Format &format) const -> bool = default;
+    };
+
+    // Appends the number to the text.
+    static void number(std::string &text, const double &value, const Format &format = Format())
+    {
+        std::array<char, 400> buffer{};
+        auto [end, error] = format.precision < 0
+                            ? std::to_chars(buffer.data(), buffer.data() + buffer.size(), value)
+                            : std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
+                                            std::chars_format::fixed, std::min(format.precision, 17));
+        if (error != std::errc()) {
+            text += std::to_string(value);
+            return;
+        }
+
+        auto begin = buffer.data();
+        if (format.trim && format.precision >= 0 && std::find(begin, end, '.') != end) {
+            while (*(end - 1) == '0') {
+                --end;
+            }
+            if (*(end - 1) == '.') {
+                --end;
+            }
+        }
+        // Negative zero.
+        if (end - begin == 2 && begin[0] == '-' && begin[1] == '0') {
+            ++begin;
+        }
+        text.append(begin, end);
+    }
+
+    // Returns the number as text.
+    static auto number(const double &value, const Format &format = Format()) -> std::string
+    {
+        std::string text;
+        number(text, value, format);
+
+        return text;
+    }
+
+    // Appends the point as "x y" to the text.
+    static void number(std::string &text, const std::array<double, 2> &point, const Format &format = Format())
+    {
+        number(text, point.front(), format);
+        text += ' ';
+        number(text, point.back(), format);
+    }
+
+    // Appends value * 10^-decimals, exact : integer formatting, the trailing zeros removed.
+    static void fixed(std::string &text, long long value, int decimals = 0)
+    {
+        std::array<char, 24> buffer{};
+        if (decimals <= 0) {
+            text.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr);
+            return;
+        }
+
+        auto magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+        std::string digits(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), magnitude).ptr);
+        if (digits.size() <= static_cast<size_t>(decimals)) {
+            digits.insert(0, static_cast<size_t>(decimals) + 1 - digits.size(), '0');
+        }
+        digits.insert(digits.size() - static_cast<size_t>(decimals), 1, '.');
+        while (digits.back() == '0') {
+            digits.pop_back();
+        }
+        if (digits.back() == '.') {
+            digits.pop_back();
+        }
+        if (value < 0) {
+            text += '-';
+        }
+        text += digits;
+    }
+
+    // Appends compact path data ("d" attribute) to the text.
+    // Coordinates rounded to the precision, then per segment the shorter of absolute and relative
+    // lineto (L, l), horizontal (H, h) or vertical (V, v), repeated commands implicit and separators only
+    // where required. Relative commands need a fixed precision, otherwise only absolute ones are used.
+    static void path(std::string &text, const std::vector<std::array<double, 2> > &points, bool closed,
+                     const Format &format = Format())
+    {
+        if (points.empty()) {
+            return;
+        }
+
+        const auto precision = format.precision;
+        const auto relative = precision >= 0;
+        const auto scale = std::pow(10.0, std::min(precision, 17));
+        auto quantize = [&](const double &value) {
+            return relative ? std::round(value * scale) / scale : value;
+        };
+
+        // Separator only between two numbers that would merge.
+        bool dot = false;
+        auto append = [&](const std::string &token, bool isNumber) {
+            if (isNumber && !text.empty()) {
+                auto last = text.back();
+                if ((last >= '0' && last <= '9') || last == '.') {
+                    if ((token[0] >= '0' && token[0] <= '9') || (token[0] == '.' && !dot)) {
+                        text += ' ';
+                    }
+                }
+            }
+            text += token;
+            dot = isNumber && token.find_first_of(".e") != std::string::npos;
+        };
+
+        std::string first, second, alternative1, alternative2;
+        // Number without the leading zero : 0.5 = .5
+        auto write = [&format](std::string &token, const double &value) {
+            token.clear();
+            number(token, value, format);
+            auto zero = token[0] == '-' ? 1 : 0;
+            if (token.size() > static_cast<size_t>(zero) + 1 && token[zero] == '0' && token[zero + 1] == '.') {
+                token.erase(zero, 1);
+            }
+        };
+
+        auto x = quantize(points[0].front());
+        auto y = quantize(points[0].back());
+        write(first, x);
+        write(second, y);
+        append("M", false);
+        append(first, true);
+        append(second, true);
+        char command = 'L';
+
+        auto count = points.size();
+        while (closed && count > 1 && quantize(points[count - 1].front()) == quantize(points[0].front()) &&
+               quantize(points[count - 1].back()) == quantize(points[0].back())) {
+            --count;
+        }
+
+        for (size_t i = 1; i < count; ++i) {
+            auto px = quantize(points[i].front());
+            auto py = quantize(points[i].back());
+            if (px == x && py == y) {
+                continue;
+            }
+
+            char next = 0;
+            size_t values = 2;
+            if (py == y) {
+                write(first, px);
+                write(alternative1, px - x);
+                next = 'H';
+                values = 1;
+            }
+            else if (px == x) {
+                write(first, py);
+                write(alternative1, py - y);
+                next = 'V';
+                values = 1;
+            }
+            else {
+                write(first, px);
+                write(second, py);
+                write(alternative1, px - x);
+                write(alternative2, py - y);
+                next = 'L';
+            }
+
+            auto absolute = first.size() + (values == 2 ? second.size() : 0);
+            auto delta = alternative1.size() + (values == 2 ? alternative2.size() : 0);
+            if (relative && delta < absolute) {
+                next = static_cast<char>(next - 'A' + 'a');
+                std::swap(first, alternative1);
+                std::swap(second, alternative2);
+            }
+
+            if (next != command) {
+                append(std::string(1, next), false);
+                command = next;
+            }
+            append(first, true);
+            if (values == 2) {
+                append(second, true);
+            }
+            x = px;
+            y = py;
+        }
+
+        if (closed) {
+            append("Z", false);
+        }
+    }
+
+    // Returns compact path data ("d" attribute).
+    static auto path(const std::vector<std::array<double, 2> > &points, bool closed,
+                     const Format &format = Format()) -> std::string
+    {
+        std::string text;
+        text.reserve(points.size() * 10);
+        path(text, points, closed, format);
+
+        return text;
+    }
+
     // Returns SVG: <g> Elements </g>
     static auto group(std::string id, const std::string &elements) -> std::string
     {
@@ -261,123 +525,414 @@ public:
         return elements.empty() ? "" : id + elements + "</g>\n";
     }
 
-private:
-
-    // Validates and formats entries.
-    static auto style(Style style, const std::string &name) -> std::string
+    // Returns the style declarations : "opacity:...;fill:...;stroke:...".
+    static auto declarations(Style style, const Format &format = Format()) -> std::string
     {
-        style.name = name.empty() ? "Shape" : name;
         style.stroke = style.stroke.empty() ? "#000000" : style.stroke;
         style.fillOpacity = style.fillOpacity < 0 ? 0 : std::min(style.fillOpacity / 255, 1.0);
         style.strokeOpacity = style.strokeOpacity < 0 ? 0 : std::min(style.strokeOpacity / 255, 1.0);
 
-        return {
-                "id=\"" + style.name + "\"\nstyle=\"" +
-                "opacity:" + std::to_string(style.fillOpacity) + ";fill:" + style.fill +
-                ";stroke:" + style.stroke + ";stroke-width:" + std::to_string(style.strokeWidth) +
-                ";stroke-opacity:" + std::to_string(style.strokeOpacity) +
-                ";stroke-linejoin:round;stroke-linecap:round\"\n" };
+        std::string result = "opacity:";
+        number(result, style.fillOpacity, format);
+        result += ";fill:" + style.fill + ";stroke:" + style.stroke + ";stroke-width:";
+        number(result, style.strokeWidth, format);
+        result += ";stroke-opacity:";
+        number(result, style.strokeOpacity, format);
+        result += ";stroke-linejoin:round;stroke-linecap:round";
+
+        return result;
+    }
+
+private:
+
+    // Validates and formats entries.
+    static auto style(const Style &style, const std::string &name, const Format &format) -> std::string
+    {
+        auto id = "id=\"" + (name.empty() ? std::string("Shape") : name) + "\"\n";
+        if (!style.className.empty()) {
+            return id + "class=\"" + style.className + "\"\n";
+        }
+
+        return id + "style=\"" + declarations(style, format) + "\"\n";
     }
 
 public:
 
     // Return SVG: <polyline ... />
-    static auto polyline(const NormalShape &shape) -> std::string
+    static auto polyline(const NormalShape &shape, const Format &format = Format()) -> std::string
     {
         if (shape.points.empty()) {
             return "<!-- Empty -->\n";
         }
 
+        if (format.compact) {
+            return "<path\n" + style(shape, shape.name, format) + "d=\"" + path(shape.points, false, format) + "\" />\n";
+        }
+
         std::string values;
+        values.reserve(shape.points.size() * 16);
         for (const auto &point : shape.points) {
-            values += std::to_string(point.front()) + " " + std::to_string(point.back());
+            if (!values.empty()) {
+                values += ' ';
+            }
+            number(values, point, format);
+        }
+
+        return {
+            "<polyline\n" + style(shape, shape.name, format) + "points=\"" + values + "\" />\n"
+        };
+    }
+
+    // Return SVG: <path ... />
+    static auto polygon(const NormalShape &shape, const Format &format = Format()) -> std::string
+    {
+        if (shape.points.empty()) {
+            return "<!-- Empty -->\n";
+        }
+
+        if (format.compact) {
+            return "<path\n" + style(shape, shape.name, format) + "d=\"" + path(shape.points, true, format) + "\" />\n";
+        }
+
+        std::string values;
+        values.reserve(shape.points.size() * 20);
+        for (unsigned i = 0; i < shape.points.size(); i++) {
+            if (i > 0) {
+                values += " L ";
+            }
+            number(values, shape.points[i], format);
+        }
+
+        return {
+            "<path\n" + style(shape, shape.name, format) + "d=\"M " + values + " Z\" />\n"
+        };
+    }
+
+    // Return SVG: <path ... /> with several closed contours, filled with the even-odd rule :
+    // the contours inside others are holes.
+    static auto region(const Style &shape, const std::vector<std::vector<std::array<double, 2> > > &contours,
+                       const Format &format = Format()) -> std::string
+    {
+        std::string values;
+        for (const auto &contour : contours) {
+            if (contour.empty()) {
+                continue;
+            }
+            if (format.compact) {
+                values += values.empty() ? "" : " ";
+                values += path(contour, true, format);
+                continue;
+            }
+            for (unsigned i = 0; i < contour.size(); i++) {
+                values += i == 0 ? (values.empty() ? "M " : " M ") : " L ";
+                number(values, contour[i], format);
+            }
+            values += " Z";
+        }
+        if (values.empty()) {
+            return "<!-- Empty -->\n";
         }
 
         return {
-            "<polyline\n" + style(shape, shape.name) + "points=\"" + values + "\" />\n"
+            "<path\n" + style(shape, shape.name, format) + "fill-rule=\"evenodd\"\nd=\"" + values + "\" />\n"
         };
     }
 
     // Return SVG: <path ... />
-    static auto polygon(const NormalShape &shape) -> std::string
+    static auto polygon(const IntegerShape &shape, const Format &format = Format()) -> std::string
     {
         if (shape.points.empty()) {
             return "<!-- Empty -->\n";
         }
 
         std::string values;
-        for (unsigned i = 0; i < shape.points.size() - 1; i++) {
-            values += std::to_string(shape.points[i].front()) + " " + std::to_string(shape.points[i].back()) + " L ";
+        values.reserve(shape.points.size() * 12);
+        for (unsigned i = 0; i < shape.points.size(); i++) {
+            values += i == 0 ? "" : " L ";
+            fixed(values, shape.points[i].front(), shape.decimals);
+            values += ' ';
+            fixed(values, shape.points[i].back(), shape.decimals);
+        }
+
+        return {
+            "<path\n" + style(shape, shape.name, format) + "d=\"M " + values + " Z\" />\n"
+        };
+    }
+
+    // Return SVG: <path ... /> with quadratic (Q) or cubic (C) Bezier curves.
+    // points : Start point followed by the control points and the end point of each curve.
+    // degree : 2 (quadratic) or 3 (cubic).
+    // closed : Closes the path (Z).
+    static auto bezier(const NormalShape &shape, unsigned degree = 3, bool closed = false,
+                       const Format &format = Format()) -> std::string
+    {
+        if (degree < 2 || degree > 3 || shape.points.size() < degree + 1 || (shape.points.size() - 1) % degree != 0) {
+            return "<!-- Empty -->\n";
+        }
+
+        std::string values = "M ";
+        number(values, shape.points[0], format);
+        for (unsigned i = 1; i < shape.points.size(); i++) {
+            values += (i - 1) % degree == 0 ? (degree == 2 ? " Q " : " C ") : " ";
+            number(values, shape.points[i], format);
+        }
+
+        return {
+            "<path\n" + style(shape, shape.name, format) + "d=\"" + values + (closed ? " Z" : "") + "\" />\n"
+        };
+    }
+
+    // Return SVG: <path ... /> with elliptical arcs (A).
+    static auto arc(const ArcShape &shape, const Format &format = Format()) -> std::string
+    {
+        if (shape.points.size() < 2 || shape.horizontalRadius <= 0 || shape.verticalRadius <= 0) {
+            return "<!-- Empty -->\n";
+        }
+
+        std::string parameters = " A ";
+        number(parameters, {shape.horizontalRadius, shape.verticalRadius}, format);
+        parameters += ' ';
+        number(parameters, shape.rotation, format);
+        parameters += std::string(" ") + (shape.largeArc ? "1" : "0") + " " + (shape.sweep ? "1" : "0") + " ";
+
+        std::string values = "M ";
+        number(values, shape.points[0], format);
+        for (unsigned i = 1; i < shape.points.size(); i++) {
+            values += parameters;
+            number(values, shape.points[i], format);
         }
-        values += std::to_string(shape.points[shape.points.size() - 1].front()) + " " +
-                  std::to_string(shape.points[shape.points.size() - 1].back());
 
         return {
-            "<path\n" + style(shape, shape.name) + "d=\"M " + values + " Z\" />\n"
+            "<path\n" + style(shape, shape.name, format) + "d=\"" + values + "\" />\n"
         };
     }
 
+    // Return SVG elements 0 .. count - 1, element(i, text) appends the element i to the text.
+    // The elements are split in contiguous chunks between threads (0 : hardware concurrency),
+    // each chunk written to its own buffer, then concatenated in order : same output as one thread.
+    // element must not change shared state (see clone IDs), its Format is captured by the caller.
+    template<typename Element>
+    static auto elements(size_t count, Element element, unsigned threads = 0) -> std::string
+    {
+        threads = threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+        // Small scenes are not worth the threads.
+        threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, count / 256)));
+
+        std::string result{};
+        if (threads == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                element(i, result);
+            }
+            return result;
+        }
+
+        auto chunk = (count + threads - 1) / threads;
+        std::vector<std::string> buffers((count + chunk - 1) / chunk);
+        std::vector<std::thread> workers;
+        for (size_t begin = 0, index = 0; begin < count; begin += chunk, ++index) {
+            auto end = std::min(count, begin + chunk);
+            workers.emplace_back([&, begin, end, index]() {
+                for (auto i = begin; i < end; ++i) {
+                    element(i, buffers[index]);
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        size_t size = 0;
+        for (const auto &buffer : buffers) {
+            size += buffer.size();
+        }
+        result.reserve(size);
+        for (const auto &buffer : buffers) {
+            result += buffer;
+        }
+
+        return result;
+    }
+
+    // Return SVG: polygons, the geometries repeated with only translation and rotation are
+    // written once in <defs> and referenced by <use> with a transform.
+    // Canonical geometry : vertices around their average, the first vertex on the positive x-axis.
+    // prefix : ID prefix of the geometries in <defs>.
+    static auto instances(const std::vector<NormalShape> &shapes, const std::string &prefix = "g",
+                          const Format &format = Format()) -> std::string
+    {
+        struct Instance {
+            std::vector<std::array<double, 2> > points;
+            double cosine{1}, sine{0};
+            std::array<double, 2> center{0, 0};
+            size_t geometry{0};
+        };
+
+        std::unordered_map<std::string, size_t> geometries;
+        std::vector<size_t> counts;
+        std::vector<Instance> instances(shapes.size());
+        std::string key;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            const auto &points = shapes[i].points;
+            auto &instance = instances[i];
+            if (points.empty()) {
+                continue;
+            }
+
+            for (const auto &point : points) {
+                instance.center[0] += point[0] / static_cast<double>(points.size());
+                instance.center[1] += point[1] / static_cast<double>(points.size());
+            }
+            auto angle = std::atan2(points[0][1] - instance.center[1], points[0][0] - instance.center[0]);
+            instance.cosine = std::cos(angle);
+            instance.sine = std::sin(angle);
+
+            key.clear();
+            instance.points.reserve(points.size());
+            for (const auto &point : points) {
+                auto dx = point[0] - instance.center[0];
+                auto dy = point[1] - instance.center[1];
+                instance.points.push_back({dx * instance.cosine + dy * instance.sine, dy * instance.cosine - dx * instance.sine});
+                number(key, instance.points.back(), format);
+                key += ' ';
+            }
+
+            auto [it, inserted] = geometries.try_emplace(key, counts.size());
+            if (inserted) {
+                counts.push_back(0);
+            }
+            instance.geometry = it->second;
+            counts[it->second]++;
+        }
+
+        std::string defs;
+        std::string elements;
+        std::vector<bool> defined(counts.size(), false);
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            const auto &instance = instances[i];
+            if (shapes[i].points.empty() || counts[instance.geometry] < 2) {
+                elements += polygon(shapes[i], format);
+                continue;
+            }
+
+            auto id = prefix + std::to_string(instance.geometry);
+            if (!defined[instance.geometry]) {
+                defined[instance.geometry] = true;
+                defs += "<path id=\"" + id + "\" d=\"" + path(instance.points, true, format) + "\" />\n";
+            }
+
+            elements += "<use\n" + style(shapes[i], shapes[i].name, format) + "xlink:href=\"#" + id + "\"\ntransform=\"matrix(";
+            for (auto value : {instance.cosine, instance.sine, -instance.sine, instance.cosine,
+                               instance.center[0], instance.center[1]}) {
+                number(elements, value, format);
+                elements += ' ';
+            }
+            elements.back() = ')';
+            elements += "\" />\n";
+        }
+
+        return defs.empty() ? elements : "<defs>\n" + defs + "</defs>\n" + elements;
+    }
+
     // Return SVG : <ellipse ... />
-    static auto circle(const CircleShape &circle) -> std::string
+    static auto circle(const CircleShape &circle, const Format &format = Format()) -> std::string
     {
         if (circle.horizontalRadius < 1 || circle.verticalRadius < 1) {
             return "<!-- Empty -->\n";
         }
         return {
-            "<ellipse\n" + style(circle, circle.name) +
-            "cx=\"" + std::to_string(circle.center.front()) + "\" " +
-            "cy=\"" + std::to_string(circle.center.back()) + "\" " +
-            "rx=\"" + std::to_string(circle.horizontalRadius) + "\" " +
-            "ry=\"" + std::to_string(circle.verticalRadius) + "\" />\n"
+            "<ellipse\n" + style(circle, circle.name, format) +
+            "cx=\"" + number(circle.center.front(), format) + "\" " +
+            "cy=\"" + number(circle.center.back(), format) + "\" " +
+            "rx=\"" + number(circle.horizontalRadius, format) + "\" " +
+            "ry=\"" + number(circle.verticalRadius, format) + "\" />\n"
         };
     }
 
-    // Return clone SVG.
-    // referenceName : references ID of the original SVG element.
-    // rotationAngle : rotation applied to the clone object.
+    // Clone setup.
+    // rotationAngle : rotation applied to the clone object, degrees.
     // center        : center of rotation of the clone object.
     // position      : clone object coordinate. (x,y)
-    static auto clone(const std::string &referenceName, const int &rotationAngle, const std::array<double, 2> &center,
-                      std::array<double, 2> position) -> std::string
-    {
-        static int counter = 0;
+    struct CloneShape {
+        double rotationAngle{0};
+        std::array<double, 2> center{0, 0};
+        std::array<double, 2> position{0, 0};
+    };
+
+    // Clone IDs, shared by all threads.
+    inline static std::atomic<unsigned long long> cloneCounter{0};
 
+private:
+
+    // Appends the clone to the text, cosine and sine of the rotation given.
+    static void clone(std::string &text, const std::string &referenceName, const double &cosine, const double &sine,
+                      const std::array<double, 2> &center, std::array<double, 2> position, unsigned long long id,
+                      const Format &format)
+    {
         position.front() += center.front() < 0.0 ? -center.front()  : 0.0;
         position.back() += center.back() < 0.0 ? -center.back() : 0.0;
 
         // Matrix - Rotate and Translate
-        auto a = rotationAngle * std::numbers::pi / 180.0;
         auto cx = center.front();
         auto cy = center.back();
         auto px = position.front();
         auto py = position.back();
-        std::vector<double> matrix{
-            std::cos(a), -std::sin(a), -cx *std::cos(a) + cy * sin(a) + cx + px,
-            std::sin(a),  std::cos(a), -cx *std::sin(a) - cy * cos(a) + cy + py,
-            0, 0, 1
+        const std::array<double, 6> matrix{
+            cosine, sine, -sine, cosine,
+            -cx * cosine + cy * sine + cx + px,
+            -cx * sine - cy * cosine + cy + py
         };
-        std::string transform{};
-        for (std::vector<int> index{ 0, 3, 1, 4, 2, 5 }; auto &i : index) {
-            transform += std::to_string(matrix[i]) + " ";
+
+        text += "<use \nx=\"0\"\ny=\"0\"\nxlink:href=\"#";
+        text += referenceName;
+        text += "\"\nid=\"Clone_";
+        text += referenceName;
+        text += '_';
+        std::array<char, 24> buffer{};
+        text.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), id).ptr);
+        text += "\"\ntransform=\"matrix( ";
+        for (const auto &value : matrix) {
+            number(text, value, format);
+            text += ' ';
         }
+        text += ")\"\nwidth=\"100%\"\nheight=\"100%\" />";
+    }
 
-        std::string label = "Clone_" + referenceName + "_" + std::to_string(counter++);
+public:
 
-        return {
-            "<use \n"
-            "x=\"0\"\n"
-            "y=\"0\"\n"
-            "xlink:href=\"#" + referenceName + "\"\n" +
-            "id=\"" + label + "\"\n" +
-            "transform=\"matrix( " + transform + ")\"\n" +
-            "width=\"100%\"\n"
-            "height=\"100%\" />"
-        };
+    // Return clone SVG.
+    // referenceName : references ID of the original SVG element.
+    // rotationAngle : rotation applied to the clone object, degrees.
+    // center        : center of rotation of the clone object.
+    // position      : clone object coordinate. (x,y)
+    static auto clone(const std::string &referenceName, const double &rotationAngle, const std::array<double, 2> &center,
+                      std::array<double, 2> position, const Format &format = Format()) -> std::string
+    {
+        auto a = rotationAngle * std::numbers::pi / 180.0;
+        std::string result;
+        clone(result, referenceName, std::cos(a), std::sin(a), center, position, cloneCounter++, format);
+
+        return result;
     }
 
-    // Return full SVG.
-    static auto svg(const int &width, const int &height, const std::string &xml,
-                    Metadata metadata) -> std::string
+    // Return clones SVG, one per line : the same as clone for each item, with consecutive IDs,
+    // written to a single buffer.
+    static auto clones(const std::string &referenceName, const std::vector<CloneShape> &items,
+                       const Format &format = Format()) -> std::string
+    {
+        auto first = cloneCounter.fetch_add(items.size());
+        std::string result;
+        result.reserve(items.size() * (200 + 2 * referenceName.size()));
+        for (size_t i = 0; i < items.size(); ++i) {
+            auto a = items[i].rotationAngle * std::numbers::pi / 180.0;
+            clone(result, referenceName, std::cos(a), std::sin(a), items[i].center, items[i].position, first + i, format);
+            result += '\n';
+        }
+
+        return result;
+    }
+
+    // Return SVG header : XML declaration, <svg> opening tag and metadata.
+    static auto header(const int &width, const int &height, Metadata metadata) -> std::string
     {
         std::string now;
         try {
@@ -454,12 +1009,32 @@ public:
             "</metadata>\n" +
             "<!--      Created in C++ algorithm       -->\n" +
             "<!-- Attention: do not modify this code. -->\n" +
-            "\n" + xml + "\n" +
-            "<!-- Attention: do not modify this code. -->\n" +
+            "\n"
+        };
+    }
+
+    // Return SVG footer : closes the <svg> tag.
+    static auto footer() -> std::string
+    {
+        return {
+            "\n"
+            "<!-- Attention: do not modify this code. -->\n"
             "</svg>"
         };
     }
 
+    // Return full SVG.
+    static auto svg(const int &width, const int &height, const std::string &xml,
+                    Metadata metadata) -> std::string
+    {
+        auto result = header(width, height, std::move(metadata));
+        result.reserve(result.size() + xml.size() + 64);
+        result += xml;
+        result += footer();
+
+        return result;
+    }
+
     // Return full SVG.
     static auto svg(const int &width, const int &height, const std::string &xml) -> std::string
     {
@@ -467,6 +1042,735 @@ public:
     }
 };
 
+// Shared styles : one CSS class for each distinct style.
+// Usage : shape.className = registry.add(shape), then insert css() in the document.
+class StyleRegistry {
+
+    std::unordered_map<std::string, size_t> m_classes;
+    std::vector<std::string> m_declarations;
+    std::string m_prefix;
+
+public:
+    explicit StyleRegistry(std::string prefix = "s") : m_prefix(std::move(prefix)) {}
+
+    ~StyleRegistry() = default;
+
+    // Returns the class of the style, created on first use.
+    auto add(const SVG::Style &style) -> std::string
+    {
+        auto [it, inserted] = m_classes.try_emplace(SVG::declarations(style), m_declarations.size());
+        if (inserted) {
+            m_declarations.push_back(it->first);
+        }
+
+        return m_prefix + std::to_string(it->second);
+    }
+
+    // Number of classes.
+    auto size() const -> size_t
+    {
+        return m_declarations.size();
+    }
+
+    void clear()
+    {
+        m_classes.clear();
+        m_declarations.clear();
+    }
+
+    // Returns SVG: <style> .s0{...} ... </style>
+    auto css() const -> std::string
+    {
+        if (m_declarations.empty()) {
+            return "";
+        }
+
+        std::string result = "<style>\n";
+        for (size_t i = 0; i < m_declarations.size(); ++i) {
+            result += "." + m_prefix + std::to_string(i) + "{" + m_declarations[i] + "}\n";
+        }
+        result += "</style>\n";
+
+        return result;
+    }
+};
+
+// Writes an SVG document to a stream : header, elements and footer.
+// Elements are buffered up to the capacity and then written, the document is never held in memory.
+class SvgWriter {
+
+    std::ostream &m_stream;
+    std::string m_buffer;
+    size_t m_capacity;
+    SVG::Format m_format;
+    size_t m_size{0};
+    bool m_open{true};
+
+public:
+    // format : used by the shapes written (see polyline, polygon, circle).
+    SvgWriter(std::ostream &stream, const int &width, const int &height,
+              SVG::Metadata metadata = SVG::Metadata(), size_t capacity = 64 * 1024,
+              SVG::Format format = SVG::Format())
+        : m_stream(stream), m_capacity(capacity), m_format(format)
+    {
+        m_buffer.reserve(capacity);
+        write(SVG::header(width, height, std::move(metadata)));
+    }
+
+    SvgWriter(const SvgWriter &) = delete;
+    auto operator=(const SvgWriter &) -> SvgWriter & = delete;
+
+    ~SvgWriter()
+    {
+        close();
+    }
+
+    // Appends elements, written to the stream when the buffer is full.
+    auto write(const std::string &elements) -> SvgWriter &
+    {
+        if (!m_open) {
+            return *this;
+        }
+
+        if (m_buffer.size() + elements.size() > m_capacity) {
+            flush();
+        }
+        if (elements.size() > m_capacity) {
+            m_stream.write(elements.data(), static_cast<std::streamsize>(elements.size()));
+        }
+        else {
+            m_buffer += elements;
+        }
+        m_size += elements.size();
+
+        return *this;
+    }
+
+    auto polyline(const SVG::NormalShape &shape) -> SvgWriter &
+    {
+        return write(SVG::polyline(shape, m_format));
+    }
+
+    auto polygon(const SVG::NormalShape &shape) -> SvgWriter &
+    {
+        return write(SVG::polygon(shape, m_format));
+    }
+
+    auto polygon(const SVG::IntegerShape &shape) -> SvgWriter &
+    {
+        return write(SVG::polygon(shape, m_format));
+    }
+
+    auto circle(const SVG::CircleShape &shape) -> SvgWriter &
+    {
+        return write(SVG::circle(shape, m_format));
+    }
+
+    // Writes the buffer to the stream.
+    void flush()
+    {
+        if (!m_buffer.empty()) {
+            m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_buffer.clear();
+        }
+        m_stream.flush();
+    }
+
+    // Writes the footer and flushes, the following elements are ignored.
+    void close()
+    {
+        if (m_open) {
+            write(SVG::footer());
+            flush();
+            m_open = false;
+        }
+    }
+
+    // Bytes written, buffered included.
+    auto size() const -> size_t
+    {
+        return m_size;
+    }
+
+    // Stream state.
+    auto good() const -> bool
+    {
+        return m_stream.good();
+    }
+};
+
+// Retained-mode SVG document.
+// Elements live in an arena with stable IDs (never reused), groups hold their children in order.
+// The serialized bytes of each element are cached : only the changed elements are serialized again.
+// Groups only cache their tags and size, the output goes through the cached pieces (see pieces).
+class Document {
+
+public:
+    using Id = size_t;
+
+    // The document itself, a group without <g>.
+    static constexpr Id root = 0;
+
+    enum kind {
+        GROUP, POLYGON, POLYLINE, CIRCLE, RAW
+    };
+
+private:
+    struct Element {
+        kind type{RAW};
+        Id parent{root};
+        bool alive{true};
+        bool dirty{true};
+        SVG::NormalShape normal;
+        SVG::CircleShape circle;
+        std::string text;           // Group name or raw XML.
+        std::vector<Id> children;
+        std::string bytes;          // Opening tag for a group.
+        size_t length{0};           // Serialized size, the children and tags included for a group.
+        size_t hash{0};             // Content hash of the bytes (shapes and raw XML).
+    };
+
+    std::vector<Element> m_elements;
+    int m_width, m_height;
+    SVG::Metadata m_metadata;
+    SVG::Format m_format;
+    size_t m_serializations{0};
+    size_t m_serialized{0};
+
+    auto add(Element element, Id parent) -> Id
+    {
+        if (!valid(parent) || m_elements[parent].type != GROUP) {
+            parent = root;
+        }
+        element.parent = parent;
+        m_elements.push_back(std::move(element));
+        auto id = m_elements.size() - 1;
+        m_elements[parent].children.push_back(id);
+        touch(parent);
+
+        return id;
+    }
+
+    // Marks the element and its groups.
+    void touch(Id id)
+    {
+        while (true) {
+            m_elements[id].dirty = true;
+            if (id == root) {
+                break;
+            }
+            id = m_elements[id].parent;
+        }
+    }
+
+    // Updates the cached bytes of the element and its children, returns its serialized size.
+    auto serialize(Id id) -> size_t
+    {
+        auto &element = m_elements[id];
+        if (!element.dirty) {
+            return element.length;
+        }
+
+        switch (element.type) {
+        case GROUP: {
+            size_t length = 0;
+            for (auto child : element.children) {
+                length += serialize(child);
+            }
+            // Same tags as SVG::group, nothing for an empty group.
+            if (id != root && element.bytes.empty()) {
+                element.bytes = element.text.empty() ? "<g>\n" : "<g id=\"" + element.text + "\" >\n";
+                m_serialized += element.bytes.size();
+            }
+            element.length = length == 0 || id == root ? length : element.bytes.size() + length + closing().size();
+            element.dirty = false;
+            return element.length;
+        }
+        case POLYGON:
+            element.bytes = SVG::polygon(element.normal, m_format);
+            ++m_serializations;
+            break;
+        case POLYLINE:
+            element.bytes = SVG::polyline(element.normal, m_format);
+            ++m_serializations;
+            break;
+        case CIRCLE:
+            element.bytes = SVG::circle(element.circle, m_format);
+            ++m_serializations;
+            break;
+        case RAW:
+            element.bytes = element.text;
+            break;
+        }
+        element.hash = std::hash<std::string> {}(element.bytes);
+        element.length = element.bytes.size();
+        element.dirty = false;
+        m_serialized += element.length;
+
+        return element.length;
+    }
+
+    static auto closing() -> const std::string &
+    {
+        static const std::string tag{"</g>\n"};
+
+        return tag;
+    }
+
+    // XML attribute value.
+    static auto escape(const std::string &text) -> std::string
+    {
+        std::string result;
+        result.reserve(text.size());
+        for (auto c : text) {
+            switch (c) {
+            case '&':
+                result += "&amp;";
+                break;
+            case '<':
+                result += "&lt;";
+                break;
+            case '>':
+                result += "&gt;";
+                break;
+            case '"':
+                result += "&quot;";
+                break;
+            case '\'':
+                result += "&apos;";
+                break;
+            default:
+                result += c;
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    template<typename Visit>
+    void visit(Id id, Visit &visit) const
+    {
+        const auto &element = m_elements[id];
+        if (element.length == 0) {
+            return;
+        }
+        if (element.type != GROUP) {
+            visit(element.bytes);
+            return;
+        }
+        if (id != root) {
+            visit(element.bytes);
+        }
+        for (auto child : element.children) {
+            this->visit(child, visit);
+        }
+        if (id != root) {
+            visit(closing());
+        }
+    }
+
+public:
+    // format : used by the shapes (see SVG::Format).
+    Document(const int &width, const int &height, SVG::Metadata metadata = SVG::Metadata(),
+             SVG::Format format = SVG::Format())
+        : m_width(width), m_height(height), m_metadata(std::move(metadata)), m_format(format)
+    {
+        Element document;
+        document.type = GROUP;
+        m_elements.push_back(document);
+    }
+
+    ~Document() = default;
+
+    // Adds elements to the group (root by default), returns their IDs.
+    auto polygon(const SVG::NormalShape &shape, Id group = root) -> Id
+    {
+        Element element;
+        element.type = POLYGON;
+        element.normal = shape;
+
+        return add(std::move(element), group);
+    }
+
+    auto polyline(const SVG::NormalShape &shape, Id group = root) -> Id
+    {
+        Element element;
+        element.type = POLYLINE;
+        element.normal = shape;
+
+        return add(std::move(element), group);
+    }
+
+    auto circle(const SVG::CircleShape &shape, Id group = root) -> Id
+    {
+        Element element;
+        element.type = CIRCLE;
+        element.circle = shape;
+
+        return add(std::move(element), group);
+    }
+
+    // Already serialized XML.
+    auto raw(const std::string &xml, Id group = root) -> Id
+    {
+        Element element;
+        element.type = RAW;
+        element.text = xml;
+
+        return add(std::move(element), group);
+    }
+
+    // Returns SVG::group ID.
+    auto group(const std::string &name, Id parent = root) -> Id
+    {
+        Element element;
+        element.type = GROUP;
+        element.text = name;
+
+        return add(std::move(element), parent);
+    }
+
+    // Replaces the element, the kind must match. Returns false otherwise.
+    auto update(Id id, const SVG::NormalShape &shape) -> bool
+    {
+        if (!valid(id) || (m_elements[id].type != POLYGON && m_elements[id].type != POLYLINE)) {
+            return false;
+        }
+        m_elements[id].normal = shape;
+        touch(id);
+
+        return true;
+    }
+
+    auto update(Id id, const SVG::CircleShape &shape) -> bool
+    {
+        if (!valid(id) || m_elements[id].type != CIRCLE) {
+            return false;
+        }
+        m_elements[id].circle = shape;
+        touch(id);
+
+        return true;
+    }
+
+    auto update(Id id, const std::string &text) -> bool
+    {
+        if (!valid(id) || id == root || (m_elements[id].type != RAW && m_elements[id].type != GROUP)) {
+            return false;
+        }
+        m_elements[id].text = text;
+        m_elements[id].bytes.clear();
+        touch(id);
+
+        return true;
+    }
+
+    // Removes the element, and its children for a group.
+    auto remove(Id id) -> bool
+    {
+        if (!valid(id) || id == root) {
+            return false;
+        }
+
+        auto &siblings = m_elements[m_elements[id].parent].children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), id));
+        touch(m_elements[id].parent);
+
+        std::vector<Id> stack{id};
+        while (!stack.empty()) {
+            auto current = stack.back();
+            stack.pop_back();
+            auto &element = m_elements[current];
+            element.alive = false;
+            stack.insert(stack.end(), element.children.begin(), element.children.end());
+            element.children.clear();
+            element.bytes.clear();
+        }
+
+        return true;
+    }
+
+    auto valid(Id id) const -> bool
+    {
+        return id < m_elements.size() && m_elements[id].alive;
+    }
+
+    auto type(Id id) const -> kind
+    {
+        return m_elements[id].type;
+    }
+
+    auto parent(Id id) const -> Id
+    {
+        return m_elements[id].parent;
+    }
+
+    auto children(Id id) const -> const std::vector<Id> &
+    {
+        return m_elements[id].children;
+    }
+
+    auto normalShape(Id id) const -> const SVG::NormalShape &
+    {
+        return m_elements[id].normal;
+    }
+
+    auto circleShape(Id id) const -> const SVG::CircleShape &
+    {
+        return m_elements[id].circle;
+    }
+
+    // Group name or raw XML.
+    auto text(Id id) const -> const std::string &
+    {
+        return m_elements[id].text;
+    }
+
+    // Arena size, removed elements included.
+    auto size() const -> size_t
+    {
+        return m_elements.size();
+    }
+
+    auto format() const -> const SVG::Format &
+    {
+        return m_format;
+    }
+
+    // Changes the format, the cached shapes are serialized again : one format for the whole output.
+    void format(const SVG::Format &format)
+    {
+        if (format == m_format) {
+            return;
+        }
+        m_format = format;
+        for (auto &element : m_elements) {
+            element.dirty = element.alive;
+        }
+    }
+
+    // Shapes serialized since the creation.
+    auto serializations() const -> size_t
+    {
+        return m_serializations;
+    }
+
+    // Bytes serialized since the creation : shapes, raw XML and group tags. The output is not counted.
+    auto serialized() const -> size_t
+    {
+        return m_serialized;
+    }
+
+    // Calls visit(const std::string &) with the cached pieces of the element in document order,
+    // the concatenation is the serialized element : nothing is copied.
+    template<typename Visit>
+    void pieces(Visit visit, Id id = root)
+    {
+        serialize(id);
+        this->visit(id, visit);
+    }
+
+    // Serialized element.
+    auto bytes(Id id) -> std::string
+    {
+        std::string result;
+        result.reserve(serialize(id));
+        pieces([&result](const std::string &piece) {
+            result += piece;
+        }, id);
+
+        return result;
+    }
+
+    // Returns full SVG.
+    auto svg() -> std::string
+    {
+        auto result = SVG::header(m_width, m_height, m_metadata);
+        result.reserve(result.size() + serialize(root) + 64);
+        pieces([&result](const std::string &piece) {
+            result += piece;
+        });
+        result += SVG::footer();
+
+        return result;
+    }
+
+    // Writes full SVG to the stream, piece by piece.
+    void write(std::ostream &stream)
+    {
+        SvgWriter writer(stream, m_width, m_height, m_metadata);
+        pieces([&writer](const std::string &piece) {
+            writer.write(piece);
+        });
+    }
+
+    // Difference between two versions of a document.
+    // ADD    : new element in the parent group at the position among its children,
+    //          text : serialized bytes or group name,
+    // REMOVE : element and its children removed,
+    // CHANGE : new serialized bytes, or new group name.
+    struct Change {
+        enum operation {
+            ADD, REMOVE, CHANGE
+        };
+
+        operation op{ADD};
+        Id id{root};
+        Id parent{root};
+        bool group{false};
+        std::string text;
+        size_t position{0};
+    };
+
+    using Patch = std::vector<Change>;
+
+    // Compares two versions of the same document (the IDs are shared) by ID and content hash.
+    // Changes ordered : removals and changes by ID, then additions in document order
+    // (a group before its children, the siblings by position).
+    static auto diff(Document &before, Document &after) -> Patch
+    {
+        before.serialize(root);
+        after.serialize(root);
+
+        Patch removals;
+        Patch result;
+        auto size = std::max(before.size(), after.size());
+        // Elements removed and added again (parent or kind changed), with their children.
+        std::vector<bool> replaced(size, false);
+        std::vector<bool> added(size, false);
+        for (Id id = 1; id < size; ++id) {
+            auto old = before.valid(id);
+            auto now = after.valid(id);
+            if (old) {
+                // Children of a removed group are implied.
+                auto parent = before.m_elements[id].parent;
+                auto implied = replaced[parent] || (parent != root && !after.valid(parent));
+                const auto &a = before.m_elements[id];
+                if (now) {
+                    const auto &b = after.m_elements[id];
+                    if (replaced[parent] || a.parent != b.parent || (a.type == GROUP) != (b.type == GROUP)) {
+                        replaced[id] = true;
+                        if (!implied) {
+                            removals.push_back({Change::REMOVE, id, a.parent, a.type == GROUP, ""});
+                        }
+                        added[id] = true;
+                    }
+                    else if (b.type == GROUP ? a.text != b.text : (a.hash != b.hash || a.bytes != b.bytes)) {
+                        result.push_back({Change::CHANGE, id, b.parent, b.type == GROUP, b.type == GROUP ? b.text : b.bytes});
+                    }
+                }
+                else if (!implied) {
+                    removals.push_back({Change::REMOVE, id, parent, a.type == GROUP, ""});
+                }
+            }
+            else if (now) {
+                added[id] = true;
+            }
+        }
+        removals.insert(removals.end(), result.begin(), result.end());
+
+        // Additions in document order : each one inserted at its position finds its previous siblings.
+        std::vector<Id> stack(after.m_elements[root].children.rbegin(), after.m_elements[root].children.rend());
+        while (!stack.empty()) {
+            auto id = stack.back();
+            stack.pop_back();
+            const auto &b = after.m_elements[id];
+            if (added[id]) {
+                const auto &siblings = after.m_elements[b.parent].children;
+                auto position = static_cast<size_t>(std::find(siblings.begin(), siblings.end(), id) - siblings.begin());
+                removals.push_back({Change::ADD, id, b.parent, b.type == GROUP, b.type == GROUP ? b.text : b.bytes, position});
+            }
+            stack.insert(stack.end(), b.children.rbegin(), b.children.rend());
+        }
+
+        return removals;
+    }
+
+    // Applies the changes, the elements added or changed become raw XML (or groups).
+    // An element added over a live one replaces it (the old one is removed with its children).
+    void apply(const Patch &patch)
+    {
+        for (const auto &change : patch) {
+            switch (change.op) {
+            case Change::REMOVE:
+                remove(change.id);
+                break;
+            case Change::ADD: {
+                if (change.id == root) {
+                    break;
+                }
+                if (change.id >= m_elements.size()) {
+                    Element removed;
+                    removed.alive = false;
+                    m_elements.resize(change.id + 1, removed);
+                }
+                remove(change.id);
+                auto parent = valid(change.parent) && m_elements[change.parent].type == GROUP ? change.parent : root;
+                Element element;
+                element.type = change.group ? GROUP : RAW;
+                element.text = change.text;
+                element.parent = parent;
+                m_elements[change.id] = element;
+                auto &siblings = m_elements[parent].children;
+                siblings.insert(siblings.begin() + static_cast<long>(std::min(change.position, siblings.size())), change.id);
+                touch(change.id);
+                break;
+            }
+            case Change::CHANGE:
+                if (valid(change.id)) {
+                    auto &element = m_elements[change.id];
+                    if (element.type != GROUP) {
+                        element.type = RAW;
+                    }
+                    element.text = change.text;
+                    element.bytes.clear();
+                    touch(change.id);
+                }
+                break;
+            }
+        }
+    }
+
+    // Returns the patch as XML :
+    // <patch> <remove id="1" /> <add id="2" parent="0" position="0">...</add>
+    // <group id="3" parent="0" position="1" name="..." /> <change id="4">...</change> <rename id="3" name="..." /> </patch>
+    // The group names are escaped.
+    static auto patch(const Patch &changes) -> std::string
+    {
+        std::string result = "<patch>\n";
+        for (const auto &change : changes) {
+            auto id = std::to_string(change.id);
+            switch (change.op) {
+            case Change::REMOVE:
+                result += "<remove id=\"" + id + "\" />\n";
+                break;
+            case Change::ADD: {
+                auto place = "\" parent=\"" + std::to_string(change.parent) + "\" position=\"" + std::to_string(change.position) + "\"";
+                if (change.group) {
+                    result += "<group id=\"" + id + place + " name=\"" + escape(change.text) + "\" />\n";
+                }
+                else {
+                    result += "<add id=\"" + id + place + ">\n" + change.text + "</add>\n";
+                }
+                break;
+            }
+            case Change::CHANGE:
+                if (change.group) {
+                    result += "<rename id=\"" + id + "\" name=\"" + escape(change.text) + "\" />\n";
+                }
+                else {
+                    result += "<change id=\"" + id + "\">\n" + change.text + "</change>\n";
+                }
+                break;
+            }
+        }
+        result += "</patch>\n";
+
+        return result;
+    }
+};
+
 }; // namespace Image
 
 }; // namespace stbox
@@ -3,11 +3,16 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <future>
 #include <map>
 #include <numbers>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 
@@ -129,7 +134,8 @@ static auto round(std::vector<double> values, int decimalPlaces) -> std::vector<
 }
 
 // Sort numbers.
-static auto sort(std::vector<double> numbers, bool ascendingOrder = true) -> std::vector<double>
+template<typename T = double>
+static auto sort(std::vector<T> numbers, bool ascendingOrder = true) -> std::vector<T>
 {
     if (ascendingOrder) {
         std::sort(numbers.begin(), numbers.end(), std::less<>());
@@ -155,19 +161,6 @@ static auto triangleArea(const double &x0, const double &y0,
     return std::sqrt(s * (s - a) * (s - b) * (s - c));
 }
 
-// Calculates the greatest height formed by three coordinates.
-static auto triangleHeight(const double &x0, const double &y0,
-                           const double &x1, const double &y1,
-                           const double &x2, const double &y2) -> double
-{
-    auto area = triangleArea(x0, y0, x1, y1, x2, y2);
-    auto height0 = 2 * area / distance(x0, y0, x1, y1);
-    auto height1 = 2 * area / distance(x1, y1, x2, y2);
-    auto height2 = 2 * area / distance(x2, y2, x0, y0);
-
-    return std::max(std::max(height0, height1), height2);
-}
-
 // Pseudo-random positive number generation.
 template<typename T = int>
 static auto randomize(int number1, int number2 = 0) -> T
@@ -221,10 +214,19 @@ static auto equal(const std::vector<T> &group1, const std::vector<T> &group2, bo
 }
 
 // Point 2D (x,y)
-class Point {
+// T : coordinate type (float, double).
+// Coordinates are stored as T, measurements are returned as double.
+// The point keeps its label : the memory saving of float coordinates is for the polygon
+// vertices (see Vertex), not for the points.
+template<typename T = double>
+class BasicPoint {
 
+public:
+    using Point = BasicPoint;
+
+private:
     struct Coordinate {
-        double value{0};
+        T value{0};
 
         auto toInt() -> const int
         {
@@ -250,19 +252,19 @@ public:
     std::string label{"Point"};
 
     // Point (0, 0)
-    Point() : X{0}, Y{0} {};
+    BasicPoint() : X{0}, Y{0} {};
 
     // Point (x, y)
-    Point(const double &x, const double &y) : X{x}, Y{y} {};
+    BasicPoint(const T &x, const T &y) : X{x}, Y{y} {};
 
-    ~Point() = default;
+    ~BasicPoint() = default;
 
     auto operator+(const Point &point) const -> Point
     {
         return {X.value + point.X.value, Y.value + point.Y.value};
     }
 
-    auto operator+(const double &value) const -> Point
+    auto operator+(const T &value) const -> Point
     {
         return {X.value + value, Y.value + value};
     }
@@ -272,7 +274,7 @@ public:
         sum(point.X.value, point.Y.value);
     }
 
-    void operator+=(const double &value)
+    void operator+=(const T &value)
     {
         sum(value, value);
     }
@@ -282,7 +284,7 @@ public:
         return {X.value - point.X.value, Y.value - point.Y.value};
     }
 
-    auto operator-(const double &value) const -> Point
+    auto operator-(const T &value) const -> Point
     {
         return {X.value - value, Y.value - value};
     }
@@ -292,7 +294,7 @@ public:
         sum(-point.X.value, -point.Y.value);
     }
 
-    void operator-=(const double &value)
+    void operator-=(const T &value)
     {
         sum(-value, -value);
     }
@@ -302,7 +304,7 @@ public:
         return {X.value * point.X.value, Y.value * point.Y.value};
     }
 
-    auto operator*(const double &value) const -> Point
+    auto operator*(const T &value) const -> Point
     {
         return {X.value * value, Y.value * value};
     }
@@ -312,7 +314,7 @@ public:
         multiply(point.X.value, point.Y.value);
     }
 
-    void operator*=(const double &value)
+    void operator*=(const T &value)
     {
         multiply(value, value);
     }
@@ -323,15 +325,15 @@ public:
     }
 
     // X += x, Y += y
-    void sum(const double &x, const double &y)
+    void sum(const T &x, const T &y)
     {
         X.value += x;
         Y.value += y;
     }
 
     // Returns each coordinate by adding value.
-    template <typename T>
-    static auto sum(const std::vector<Point> &points, const T &value) -> std::vector<Point>
+    template <typename V>
+    static auto sum(const std::vector<Point> &points, const V &value) -> std::vector<Point>
     {
         std::vector<Point> result{};
         for (const auto &p : points) {
@@ -359,11 +361,11 @@ public:
             return {Point(), false};
         }
 
-        return {total(points) *(1.0 / static_cast<double>(points.size())), true};
+        return {total(points) * static_cast<T>(1.0 / static_cast<double>(points.size())), true};
     }
 
     // X *= x; Y *= y
-    void multiply(const double &x, const double &y)
+    void multiply(const T &x, const T &y)
     {
         X.value *= x;
         Y.value *= y;
@@ -422,8 +424,8 @@ public:
     // Current point as origin.
     auto position(const double &angle, const double &horizontalRadius, const double &verticalRadius) const -> Point
     {
-        return {Math::cos(X.value, horizontalRadius, angle),
-                Math::sin(Y.value, verticalRadius, angle)};
+        return {static_cast<T>(Math::cos(X.value, horizontalRadius, angle)),
+                static_cast<T>(Math::sin(Y.value, verticalRadius, angle))};
     }
 
     // Position from angle and radius.
@@ -452,17 +454,23 @@ public:
     // Greatest height formed between current point and two others.
     auto triangleHeight(const Point &point1, const Point &point2) const -> double
     {
-        return Math::triangleHeight(X.value, Y.value,
-                                    point1.X.value, point1.Y.value,
-                                    point2.X.value, point2.Y.value);
+        return triangleHeight(*this, point1, point2);
     }
 
-    // Greatest height formed between three points.
+    // Greatest height formed between three points : twice the area over the shortest side.
     static auto triangleHeight(const Point &point1, const Point &point2, const Point &point3)  -> double
     {
-        return Math::triangleHeight(point1.X.value, point1.Y.value,
-                                    point2.X.value, point2.Y.value,
-                                    point3.X.value, point3.Y.value);
+        auto squared = [](const Point &a, const Point &b) {
+            return (b.X.value - a.X.value) * (b.X.value - a.X.value) + (b.Y.value - a.Y.value) * (b.Y.value - a.Y.value);
+        };
+        auto side = std::min({squared(point1, point2), squared(point2, point3), squared(point3, point1)});
+        if (side == 0) {
+            return 0;
+        }
+        auto cross = (point2.X.value - point1.X.value) * (point3.Y.value - point1.Y.value) -
+                     (point2.Y.value - point1.Y.value) * (point3.X.value - point1.X.value);
+
+        return std::abs(cross) / std::sqrt(side);
     }
 
     // Calculates the point of intersection between two lines.
@@ -493,10 +501,10 @@ public:
         double u =  b / d;
 
         if (t >= 0.0 && t <= 1.0 && u >= 0 && u <= 1.0) {
-            Point p{x0 + t *(x1 - x0), y0 + t *(y1 - y0)};
+            Point p(x0 + t * (x1 - x0), y0 + t * (y1 - y0));
             // Check if the intersection point belongs to the two lines.
-            if ((p.distance({x0, y0}) + p.distance({x1, y1}) == Point(x0, y0).distance({x1, y1}))
-                && (p.distance({x2, y2}) + p.distance({x3, y3}) == Point(x2, y2).distance({x3, y3}))) {
+            if ((p.distance(Point(x0, y0)) + p.distance(Point(x1, y1)) == Point(x0, y0).distance(Point(x1, y1)))
+                && (p.distance(Point(x2, y2)) + p.distance(Point(x3, y3)) == Point(x2, y2).distance(Point(x3, y3)))) {
                 return {p, 2};
             }
             // Intersection outside the line range.
@@ -527,8 +535,8 @@ public:
     // Returns the rounded current coordinates.
     auto round(int decimalPlaces = 2) const -> Point
     {
-        return {Math::round(X.value, decimalPlaces),
-                Math::round(Y.value, decimalPlaces)};
+        return {static_cast<T>(Math::round(X.value, decimalPlaces)),
+                static_cast<T>(Math::round(Y.value, decimalPlaces))};
     }
 
     // Round points.
@@ -543,7 +551,7 @@ public:
     }
 
     // Returns Vector[2] with X and Y values.
-    auto XY() -> std::array<double, 2>
+    auto XY() -> std::array<T, 2>
     {
         return {X.value, Y.value};
     }
@@ -559,7 +567,7 @@ public:
             return points;
         }
 
-        std::map<double, std::vector<double> > mapPoint;
+        std::map<T, std::vector<T> > mapPoint;
 
         for (const auto &point : points) {
             auto key = X_axis ? point.X.value : point.Y.value;
@@ -598,7 +606,7 @@ public:
         }
 
         // Map : Angle x Point.
-        std::map<double, std::vector<Point>> mapPoint;
+        std::map<double, std::vector<Point> > mapPoint;
 
         for (const auto &value : points) {
             auto key = center.angle(value);
@@ -620,6 +628,147 @@ public:
         return result;
     }
 
+    // Reduces the number of vertices (Douglas-Peucker).
+    // Tolerance : maximum distance between the removed vertices and the result.
+    // Closed    : treats the points as a polygon.
+    static auto simplify(const std::vector<Point> &points, const double &tolerance, bool closed = false)
+        -> std::vector<Point>
+    {
+        if (points.size() < 3 || tolerance <= 0) {
+            return points;
+        }
+
+        // Squared distance between the point and the segment (a,b).
+        auto distance = [](const Point & point, const Point & a, const Point & b) {
+            double dx = b.X.value - a.X.value;
+            double dy = b.Y.value - a.Y.value;
+            double px = point.X.value - a.X.value;
+            double py = point.Y.value - a.Y.value;
+            auto length = dx * dx + dy * dy;
+            auto t = length > 0 ? std::clamp((px * dx + py * dy) / length, 0.0, 1.0) : 0.0;
+            px -= t * dx;
+            py -= t * dy;
+            return px * px + py * py;
+        };
+
+        std::vector<Point> path = points;
+        std::vector<std::pair<size_t, size_t> > stack;
+        if (closed) {
+            // Split the polygon at the farthest vertex from the first.
+            size_t farthest = 0;
+            double maximum = -1;
+            for (size_t i = 1; i < points.size(); ++i) {
+                auto d = points[i].distance(points[0]);
+                if (d > maximum) {
+                    maximum = d;
+                    farthest = i;
+                }
+            }
+            path.push_back(points[0]);
+            stack.emplace_back(0, farthest);
+            stack.emplace_back(farthest, path.size() - 1);
+        }
+        else {
+            stack.emplace_back(0, path.size() - 1);
+        }
+
+        std::vector<bool> keep(path.size(), false);
+        keep.front() = true;
+        keep.back() = true;
+        for (const auto &item : stack) {
+            keep[item.second] = true;
+        }
+
+        const auto limit = tolerance * tolerance;
+        while (!stack.empty()) {
+            auto [begin, end] = stack.back();
+            stack.pop_back();
+            size_t index = begin;
+            double maximum = 0;
+            for (auto i = begin + 1; i < end; ++i) {
+                auto d = distance(path[i], path[begin], path[end]);
+                if (d > maximum) {
+                    maximum = d;
+                    index = i;
+                }
+            }
+            if (maximum > limit) {
+                keep[index] = true;
+                stack.emplace_back(begin, index);
+                stack.emplace_back(index, end);
+            }
+        }
+
+        std::vector<Point> result;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (keep[i]) {
+                result.push_back(path[i]);
+            }
+        }
+        if (!closed && !result.back().equal(points.back())) {
+            result.push_back(points.back());
+        }
+
+        return result;
+    }
+
+    // Merges the points closer than the tolerance into the first of them (hash grid, O(n) expected)
+    // and removes the resulting zero-length edges.
+    // Closed : treats the points as a polygon, the last point is not repeated.
+    static auto weld(const std::vector<Point> &points, const double &tolerance, bool closed = false)
+        -> std::vector<Point>
+    {
+        const auto size = tolerance > 0 ? tolerance : 1.0;
+        const auto limit = tolerance > 0 ? tolerance * tolerance : 0.0;
+        auto key = [&](long long x, long long y) {
+            return static_cast<unsigned long long>(x) * 73856093ULL ^ static_cast<unsigned long long>(y) * 19349663ULL;
+        };
+
+        // Buckets : first representative and a chain through the others.
+        std::unordered_map<unsigned long long, size_t> head;
+        head.reserve(points.size());
+        std::vector<size_t> chain;
+        std::vector<Point> representatives;
+
+        std::vector<Point> result;
+        result.reserve(points.size());
+        for (const auto &point : points) {
+            auto cx = static_cast<long long>(std::floor(point.X.value / size));
+            auto cy = static_cast<long long>(std::floor(point.Y.value / size));
+
+            const Point *found = nullptr;
+            for (auto x = cx - 1; x <= cx + 1 && !found; ++x) {
+                for (auto y = cy - 1; y <= cy + 1 && !found; ++y) {
+                    auto it = head.find(key(x, y));
+                    for (auto i = it == head.end() ? chain.size() : it->second; i < chain.size(); i = chain[i]) {
+                        double dx = representatives[i].X.value - point.X.value;
+                        double dy = representatives[i].Y.value - point.Y.value;
+                        if (dx * dx + dy * dy <= limit) {
+                            found = &representatives[i];
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (!found) {
+                auto [it, inserted] = head.try_emplace(key(cx, cy), representatives.size());
+                chain.push_back(inserted ? std::numeric_limits<size_t>::max() : it->second);
+                it->second = representatives.size();
+                representatives.push_back(point);
+                found = &representatives.back();
+            }
+            if (result.empty() || !result.back().equal(*found)) {
+                result.push_back(*found);
+            }
+        }
+        while (closed && result.size() > 1 && result.back().equal(result.front())) {
+            result.pop_back();
+        }
+
+        return result;
+    }
+
     // Sort the std::vector<Point> clockwise using origin.
     static auto organize(const std::vector<Point> &points) -> std::vector<Point>
     {
@@ -638,19 +787,46 @@ public:
     }
 };
 
+using Point  = BasicPoint<double>;
+using PointF = BasicPoint<float>;
+
 // Special point.
 static const Point Origin = Point(0, 0);
 static const Point Zero   = Point(0, 0);
 
-class Base {
+// Polygon vertex {x, y} without label, stored contiguously by BasicBase.
+template<typename T = double>
+struct Vertex {
+    T x{0}, y{0};
+};
+
+// Polygon base (x,y)...(xN,yN)
+// T : coordinate type (float, double).
+// Vertices are stored as Vertex<T> : a float polygon uses half the memory of a double one.
+template<typename T = double>
+class BasicBase {
+
+public:
+    using Point = BasicPoint<T>;
 
+private:
     // Store the last configuration.
-    std::vector<Point> m_vertices;
+    std::vector<Vertex<T> > m_vertices;
 
     Point m_first, m_second, m_third, m_fourth, m_origin;
 
+    // Cache : bounding box {min X, min Y, max X, max Y}.
+    std::array<T, 4> m_bounds{0, 0, 0, 0};
+    bool m_boundsValid{false};
+
+    // Cache : 1 (counterclockwise) or -1 (clockwise) if strictly convex, otherwise 0.
+    int m_convexity{0};
+    bool m_convexityValid{false};
+
     void update(const Point &first, const Point &second, const Point &third, const Point &fourth)
     {
+        m_boundsValid = false;
+        m_convexityValid = false;
         m_first = first;
         m_second = second;
         m_third = third;
@@ -658,17 +834,107 @@ class Base {
         m_origin = first;
 
         if (!m_vertices.empty()) {
-            m_vertices[0] = first;
+            m_vertices[0] = vertex(first);
         }
         if (m_vertices.size() > 1) {
-            m_vertices[1] = second;
+            m_vertices[1] = vertex(second);
         }
         if (m_vertices.size() > 2) {
-            m_vertices[2] = third;
+            m_vertices[2] = vertex(third);
         }
         if (m_vertices.size() > 3) {
-            m_vertices[3] = fourth;
+            m_vertices[3] = vertex(fourth);
+        }
+    }
+
+    static auto vertex(const Point &point) -> Vertex<T>
+    {
+        return {point.X.value, point.Y.value};
+    }
+
+    auto point(size_t index) const -> Point
+    {
+        return {m_vertices[index].x, m_vertices[index].y};
+    }
+
+    auto toPoints() const -> std::vector<Point>
+    {
+        std::vector<Point> result;
+        result.reserve(m_vertices.size());
+        for (const auto &item : m_vertices) {
+            result.emplace_back(item.x, item.y);
+        }
+
+        return result;
+    }
+
+    // Every fan triangle from the first vertex has the same strict orientation,
+    // and every turn agrees with it : vertices sorted by angle around the first.
+    auto convexity() -> int
+    {
+        if (m_convexityValid) {
+            return m_convexity;
+        }
+
+        m_convexity = 0;
+        m_convexityValid = true;
+        auto sides = m_vertices.size();
+        if (sides < 3) {
+            return 0;
+        }
+
+        auto orientation = cross(m_vertices[0], m_vertices[1], m_vertices[2]) > 0 ? 1 : -1;
+        for (size_t i = 1; i + 1 < sides; ++i) {
+            if (cross(m_vertices[0], m_vertices[i], m_vertices[i + 1]) * orientation <= 0) {
+                return 0;
+            }
+        }
+        for (size_t i = 0; i < sides; ++i) {
+            if (cross(m_vertices[i], m_vertices[(i + 1) % sides], m_vertices[(i + 2) % sides]) * orientation < 0) {
+                return 0;
+            }
+        }
+        m_convexity = orientation;
+
+        return m_convexity;
+    }
+
+    static auto cross(const Point &origin, const Point &a, const Point &b) -> double
+    {
+        return cross(vertex(origin), vertex(a), vertex(b));
+    }
+
+    static auto cross(const Vertex<T> &origin, const Vertex<T> &a, const Vertex<T> &b) -> double
+    {
+        return (static_cast<double>(a.x) - origin.x) * (static_cast<double>(b.y) - origin.y) -
+               (static_cast<double>(a.y) - origin.y) * (static_cast<double>(b.x) - origin.x);
+    }
+
+    // Point in strictly convex polygon, the boundary included : O(log n).
+    // Binary search for the fan wedge around the first vertex.
+    auto wedge(const Point &target, int orientation) const -> bool
+    {
+        auto point = vertex(target);
+        const auto &v0 = m_vertices[0];
+        auto last = m_vertices.size() - 1;
+        if (cross(v0, m_vertices[1], point) * orientation < 0 ||
+            cross(v0, m_vertices[last], point) * orientation > 0) {
+            return false;
+        }
+
+        // Greatest i in [1, last - 1] with the point on the left of (v0, vi).
+        size_t low = 1, high = last - 1;
+        while (low < high) {
+            auto middle = (low + high + 1) / 2;
+            if (cross(v0, m_vertices[middle], point) * orientation >= 0) {
+                low = middle;
+            }
+            else {
+                high = middle - 1;
+            }
         }
+
+        return cross(m_vertices[low], m_vertices[low + 1], point) * orientation >= 0;
     }
 
     auto state() -> bool
@@ -686,14 +952,21 @@ public:
     {
         if (points.size() < 2) {
             m_vertices.clear();
-            return m_vertices;
+            m_boundsValid = false;
+            m_convexityValid = false;
+            return {};
         }
 
-        m_vertices = points;
-        first  = m_vertices[0];
-        second = m_vertices[1];
-        third  = points.size() > 2 ? m_vertices[2] : Point();
-        fourth = points.size() > 3 ? m_vertices[3] : Point();
+        m_vertices.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            m_vertices[i] = vertex(points[i]);
+        }
+        m_boundsValid = false;
+        m_convexityValid = false;
+        first  = points[0];
+        second = points[1];
+        third  = points.size() > 2 ? points[2] : Point();
+        fourth = points.size() > 3 ? points[3] : Point();
         origin = first;
 
         m_first  = first;
@@ -702,7 +975,7 @@ public:
         m_fourth = fourth;
         m_origin = first;
 
-        return m_vertices;
+        return points;
     }
 
     auto isConvex() -> bool
@@ -713,11 +986,11 @@ public:
         }
 
         // Cross product of two vectors.
-        auto crossProduct = [](const Point & origin, const Point & first, const Point & second) {
-            auto x1 = first.X.value  - origin.X.value;
-            auto y1 = first.Y.value  - origin.Y.value;
-            auto x2 = second.X.value - origin.X.value;
-            auto y2 = second.Y.value - origin.Y.value;
+        auto crossProduct = [](const Vertex<T> &origin, const Vertex<T> &first, const Vertex<T> &second) {
+            auto x1 = first.x  - origin.x;
+            auto y1 = first.y  - origin.y;
+            auto x2 = second.x - origin.x;
+            auto y2 = second.y - origin.y;
             return x1 * y2 - y1 * x2;
         };
 
@@ -740,21 +1013,30 @@ public:
     }
 
     // Polygon contains point.
+    // Strictly convex polygons use the O(log n) wedge test.
     auto contains(const Point &point) -> bool
     {
+        if (state()) {
+            update(first, second, third, fourth);
+        }
+        if (auto orientation = convexity(); orientation != 0) {
+            return wedge(point, orientation);
+        }
+
         int counter{0};
         for (auto i = 0; i < m_vertices.size(); ++i) {
-            auto i1 = (i + 1) % m_vertices.size();
+            auto a = this->point(i);
+            auto b = this->point((i + 1) % m_vertices.size());
             // Check if point equal vertices.
-            if (point == m_vertices[i] || point == m_vertices[i1]) {
+            if (point == a || point == b) {
                 return true;
             }
             // An imaginary horizontal line intersects an edge.
-            auto [result, status] = Point::lineIntersect(point, Point(std::numeric_limits<float>::max(), point.Y.value), m_vertices[i], m_vertices[i1]);
+            auto [result, status] = Point::lineIntersect(point, Point(std::numeric_limits<float>::max(), point.Y.value), a, b);
             if (status == 1) {  // Coincident.
                 // Check if it is out of range.
-                if (point.X.value < std::min(m_vertices[i].X.value, m_vertices[i1].X.value) ||
-                    point.X.value > std::max(m_vertices[i].X.value, m_vertices[i1].X.value)) {
+                if (point.X.value < std::min(a.X.value, b.X.value) ||
+                    point.X.value > std::max(a.X.value, b.X.value)) {
                     return false;
                 }
                 // It's on the range.
@@ -788,9 +1070,174 @@ public:
     }
 
     // Polygon contains Polygon
-    auto contains(const Base &polygon) -> std::tuple<std::vector<Point>, bool>
+    auto contains(const BasicBase &polygon) -> std::tuple<std::vector<Point>, bool>
+    {
+        return contains(polygon.toPoints());
+    }
+
+    // Pairs of edges that cross or touch each other, edges identified by the index of their first vertex.
+    // Neighbouring edges may share their common vertex only. Repeated consecutive vertices are ignored.
+    // First pair : Shamos-Hoey sweep, O(n log n). All pairs : sweep and prune.
+    auto selfIntersections(bool all = false) -> std::vector<std::array<size_t, 2> >
+    {
+        if (state()) {
+            update(first, second, third, fourth);
+        }
+
+        std::vector<Point> vertices;
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < m_vertices.size(); ++i) {
+            if (vertices.empty() || !point(i).equal(vertices.back())) {
+                vertices.push_back(point(i));
+                indices.push_back(i);
+            }
+        }
+        while (vertices.size() > 1 && vertices.back().equal(vertices.front())) {
+            vertices.pop_back();
+            indices.pop_back();
+        }
+
+        std::vector<std::array<size_t, 2> > result;
+        const auto sides = vertices.size();
+        if (sides < 3) {
+            return result;
+        }
+
+        // Edge : lexicographically sorted endpoints.
+        struct Edge {
+            Point left, right;
+        };
+        std::vector<Edge> edges(sides);
+        for (size_t i = 0; i < sides; ++i) {
+            const auto &a = vertices[i];
+            const auto &b = vertices[(i + 1) % sides];
+            auto ordered = a.X.value < b.X.value || (a.X.value == b.X.value && a.Y.value < b.Y.value);
+            edges[i] = ordered ? Edge{a, b} : Edge{b, a};
+        }
+
+        auto between = [](const Point &a, const Point &b, const Point &point) {
+            return point.X.value >= std::min(a.X.value, b.X.value) && point.X.value <= std::max(a.X.value, b.X.value) &&
+                   point.Y.value >= std::min(a.Y.value, b.Y.value) && point.Y.value <= std::max(a.Y.value, b.Y.value);
+        };
+        auto invalid = [&](size_t i, size_t j) {
+            if (j == (i + 1) % sides || i == (j + 1) % sides) {
+                // Neighbours : only a collinear overlap is invalid.
+                auto shared = j == (i + 1) % sides ? j : i;
+                const auto &a = vertices[(shared + sides - 1) % sides];
+                const auto &b = vertices[shared];
+                const auto &c = vertices[(shared + 1) % sides];
+                return cross(b, a, c) == 0 &&
+                       (a.X.value - b.X.value) * (c.X.value - b.X.value) + (a.Y.value - b.Y.value) * (c.Y.value - b.Y.value) > 0;
+            }
+            const auto &a = edges[i].left, &b = edges[i].right;
+            const auto &c = edges[j].left, &d = edges[j].right;
+            auto o1 = cross(a, b, c), o2 = cross(a, b, d);
+            auto o3 = cross(c, d, a), o4 = cross(c, d, b);
+            if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0))) {
+                return true;
+            }
+
+            return (o1 == 0 && between(a, b, c)) || (o2 == 0 && between(a, b, d)) ||
+                   (o3 == 0 && between(c, d, a)) || (o4 == 0 && between(c, d, b));
+        };
+        auto report = [&](size_t i, size_t j) {
+            result.push_back({std::min(indices[i], indices[j]), std::max(indices[i], indices[j])});
+        };
+
+        if (all) {
+            // Sweep and prune along X.
+            std::vector<size_t> order(sides);
+            for (size_t i = 0; i < sides; ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return edges[a].left.X.value < edges[b].left.X.value;
+            });
+            for (size_t k = 0; k < sides; ++k) {
+                const auto &edge = edges[order[k]];
+                auto minY = std::min(edge.left.Y.value, edge.right.Y.value);
+                auto maxY = std::max(edge.left.Y.value, edge.right.Y.value);
+                for (auto l = k + 1; l < sides && edges[order[l]].left.X.value <= edge.right.X.value; ++l) {
+                    const auto &other = edges[order[l]];
+                    if (std::max(other.left.Y.value, other.right.Y.value) < minY ||
+                        std::min(other.left.Y.value, other.right.Y.value) > maxY) {
+                        continue;
+                    }
+                    if (invalid(order[k], order[l])) {
+                        report(order[k], order[l]);
+                    }
+                }
+            }
+            std::sort(result.begin(), result.end());
+
+            return result;
+        }
+
+        // Events : 0 insert (left endpoint), 1 remove (right endpoint).
+        std::vector<std::tuple<double, double, int, size_t> > events;
+        events.reserve(2 * sides);
+        for (size_t i = 0; i < sides; ++i) {
+            events.emplace_back(edges[i].left.X.value, edges[i].left.Y.value, 0, i);
+            events.emplace_back(edges[i].right.X.value, edges[i].right.Y.value, 1, i);
+        }
+        std::sort(events.begin(), events.end());
+
+        // Status : edges ordered by height on the sweep line.
+        double sweep = 0;
+        auto height = [&](const Edge &edge) {
+            if (edge.left.X.value == edge.right.X.value) {
+                return static_cast<double>(edge.left.Y.value);
+            }
+            return edge.left.Y.value + (edge.right.Y.value - edge.left.Y.value) *
+                   (sweep - edge.left.X.value) / (edge.right.X.value - edge.left.X.value);
+        };
+        auto below = [&](size_t a, size_t b) {
+            auto ha = height(edges[a]);
+            auto hb = height(edges[b]);
+            if (ha != hb) {
+                return ha < hb;
+            }
+            auto slope = cross(edges[a].left, edges[a].right, edges[a].left + (edges[b].right - edges[b].left));
+            if (slope != 0) {
+                return slope > 0;
+            }
+            return a < b;
+        };
+        std::set<size_t, decltype(below)> status(below);
+        std::vector<typename std::set<size_t, decltype(below)>::iterator> positions(sides);
+
+        for (const auto &[x, y, type, i] : events) {
+            sweep = x;
+            if (type == 0) {
+                auto it = status.insert(i).first;
+                positions[i] = it;
+                if (it != status.begin() && invalid(*std::prev(it), i)) {
+                    report(*std::prev(it), i);
+                    break;
+                }
+                if (std::next(it) != status.end() && invalid(i, *std::next(it))) {
+                    report(i, *std::next(it));
+                    break;
+                }
+            }
+            else {
+                auto it = positions[i];
+                auto next = std::next(it);
+                if (it != status.begin() && next != status.end() && invalid(*std::prev(it), *next)) {
+                    report(*std::prev(it), *next);
+                    break;
+                }
+                status.erase(it);
+            }
+        }
+
+        return result;
+    }
+
+    // No self-intersections.
+    auto isSimple() -> bool
     {
-        return contains(polygon.m_vertices);
+        return selfIntersections().empty();
     }
 
     // Calculates the points between the intersection of two polygons.
@@ -816,7 +1263,19 @@ public:
     // Rearrange the polygon points.
     auto organize() -> std::vector<Point>
     {
-        return Point::organize(m_vertices);
+        return Point::organize(toPoints());
+    }
+
+    // Merges the vertices closer than the tolerance and removes zero-length edges.
+    // Returns vertices.
+    auto weld(const double &tolerance) -> std::vector<Point>
+    {
+        auto vertices = Point::weld(points(), tolerance, m_vertices.size() > 2);
+        if (vertices.size() != m_vertices.size()) {
+            setup(vertices);
+        }
+
+        return toPoints();
     }
 
     // Calculates the Area by triangular subdivisions.
@@ -828,12 +1287,12 @@ public:
 
         double result = 0;
         if (m_vertices.size() == 3) {
-            result = Point::triangleArea(m_vertices[0], m_vertices[1], m_vertices[2]);
+            result = Point::triangleArea(point(0), point(1), point(2));
         }
         else if (isConvex()) {
             // Calculate for convex.
             for (unsigned i = 2; i < m_vertices.size(); ++i) {
-                result += Point::triangleArea(m_vertices[0], m_vertices[i - 1], m_vertices[i]);
+                result += Point::triangleArea(point(0), point(i - 1), point(i));
             }
         }
         else {
@@ -842,8 +1301,8 @@ public:
             double calc2 = 0;
             for (int i = 0; i < m_vertices.size(); ++i) {
                 auto j = (i + 1) % m_vertices.size();
-                calc1 += m_vertices[i].X.value * m_vertices[j].Y.value;
-                calc2 += m_vertices[i].Y.value * m_vertices[j].X.value;
+                calc1 += m_vertices[i].x * m_vertices[j].y;
+                calc2 += m_vertices[i].y * m_vertices[j].x;
             }
             result = (calc1 - calc2) / 2;
         }
@@ -853,24 +1312,29 @@ public:
 
     auto perimeter() -> double
     {
-        auto perimeter = Point::sumDistances(m_vertices);
+        double perimeter{0};
+        for (size_t i = 1; i < m_vertices.size(); ++i) {
+            perimeter += point(i).distance(point(i - 1));
+        }
 
         if (m_vertices.size() > 2) {
-            perimeter += m_vertices.back().distance(m_vertices.front());
+            perimeter += point(m_vertices.size() - 1).distance(point(0));
         }
 
         return perimeter;
     }
 
-    auto equal(Base polygon, bool compareOrder = false) -> bool
+    auto equal(BasicBase polygon, bool compareOrder = false) -> bool
     {
         return Math::equal(points(), polygon.points());
     }
 
-    auto round(int decimalPlaces = 2) -> Base
+    auto round(int decimalPlaces = 2) -> BasicBase
     {
-        Base polygon;
-        polygon.m_vertices = Point::round(m_vertices, decimalPlaces);
+        BasicBase polygon;
+        for (const auto &item : Point::round(toPoints(), decimalPlaces)) {
+            polygon.m_vertices.push_back(vertex(item));
+        }
 
         return polygon;
     }
@@ -888,7 +1352,7 @@ public:
 
         std::vector<double> lengths;
         for (unsigned i = 0; i < m_vertices.size(); i++) {
-            lengths.push_back(m_vertices[i].distance(m_vertices[(i + 1) % m_vertices.size()]));
+            lengths.push_back(point(i).distance(point((i + 1) % m_vertices.size())));
         }
 
         return lengths;
@@ -911,21 +1375,62 @@ public:
             update(first, second, third, fourth);
         }
 
+        return toPoints();
+    }
+
+    // Returns the current vertices, without labels.
+    auto vertices() -> const std::vector<Vertex<T> > &
+    {
+        if (state()) {
+            update(first, second, third, fourth);
+        }
+
         return m_vertices;
     }
 
+    // Axis-aligned bounding box : Point(min X, min Y) and Point(max X, max Y).
+    // Returns Point(0,0) and Point(0,0) if there are no vertices.
+    auto boundingBox() -> std::tuple<Point, Point>
+    {
+        if (state()) {
+            update(first, second, third, fourth);
+        }
+
+        if (!m_boundsValid) {
+            m_bounds = {0, 0, 0, 0};
+            if (!m_vertices.empty()) {
+                m_bounds = {m_vertices[0].x, m_vertices[0].y,
+                            m_vertices[0].x, m_vertices[0].y
+                           };
+            }
+            for (const auto &item : m_vertices) {
+                m_bounds[0] = std::min(m_bounds[0], item.x);
+                m_bounds[1] = std::min(m_bounds[1], item.y);
+                m_bounds[2] = std::max(m_bounds[2], item.x);
+                m_bounds[3] = std::max(m_bounds[3], item.y);
+            }
+            m_boundsValid = true;
+        }
+
+        return {Point(m_bounds[0], m_bounds[1]), Point(m_bounds[2], m_bounds[3])};
+    }
+
     // Returns vertices in array
     auto pointsXY() -> std::vector<std::array<double, 2> >
     {
         std::vector<std::array<double, 2> > result;
-        for (auto point : points()) {
-            result.emplace_back(std::array<double, 2>{point.X.value, point.Y.value});
+        result.reserve(m_vertices.size());
+        for (const auto &item : vertices()) {
+            result.emplace_back(std::array<double, 2>{item.x, item.y});
         }
 
         return result;
     }
 };
 
+using Base  = BasicBase<double>;
+using BaseF = BasicBase<float>;
+
 // Line (x1,y1)(x2,y2)
 class Line : public Base {
 
@@ -1098,11 +1603,45 @@ public:
         return setup(Line(first, second), height);
     }
 
+    using Base::contains;
+
+    // Barycentric sign tests, the boundary included.
+    // A flat triangle only contains the points of its sides.
+    auto contains(const Point &point) -> bool
+    {
+        if (cross(first, second, third) == 0) {
+            return onSide(first, second, point) || onSide(second, third, point) || onSide(third, first, point);
+        }
+        auto d1 = cross(first, second, point);
+        auto d2 = cross(second, third, point);
+        auto d3 = cross(third, first, point);
+
+        return !((d1 < 0 || d2 < 0 || d3 < 0) && (d1 > 0 || d2 > 0 || d3 > 0));
+    }
+
+    auto area() -> double
+    {
+        return std::abs(cross(first, second, third)) / 2;
+    }
+
     auto height() -> double
     {
-        return first.triangleHeight(second, third);
+        return Point::triangleHeight(first, second, third);
+    }
+
+private:
+    static auto cross(const Point &a, const Point &b, const Point &c) -> double
+    {
+        return (b.X.value - a.X.value) * (c.Y.value - a.Y.value) - (b.Y.value - a.Y.value) * (c.X.value - a.X.value);
     }
 
+    // On the segment (a,b), the ends included.
+    static auto onSide(const Point &a, const Point &b, const Point &point) -> bool
+    {
+        return cross(a, b, point) == 0 &&
+               point.X.value >= std::min(a.X.value, b.X.value) && point.X.value <= std::max(a.X.value, b.X.value) &&
+               point.Y.value >= std::min(a.Y.value, b.Y.value) && point.Y.value <= std::max(a.Y.value, b.Y.value);
+    }
 };
 
 // Rectangle (x1,y1)(x2,y2)(x3,y3)(x4,y4)
@@ -1156,6 +1695,67 @@ public:
     {
         return static_cast<T>(first.distance(fourth));
     }
+
+    using Base::contains;
+
+    // Edge projections (AABB compare when axis-aligned), the boundary included.
+    // Falls back to the generic test if the vertices do not form a rectangle.
+    auto contains(const Point &point) -> bool
+    {
+        if (first.Y.value == second.Y.value && second.X.value == third.X.value &&
+            third.Y.value == fourth.Y.value && fourth.X.value == first.X.value) {
+            return point.X.value >= std::min(first.X.value, second.X.value) &&
+                   point.X.value <= std::max(first.X.value, second.X.value) &&
+                   point.Y.value >= std::min(first.Y.value, fourth.Y.value) &&
+                   point.Y.value <= std::max(first.Y.value, fourth.Y.value);
+        }
+        if (!rectangular()) {
+            return Base::contains(point);
+        }
+
+        auto ux = second.X.value - first.X.value, uy = second.Y.value - first.Y.value;
+        auto vx = fourth.X.value - first.X.value, vy = fourth.Y.value - first.Y.value;
+        auto px = point.X.value - first.X.value, py = point.Y.value - first.Y.value;
+        auto u = px * ux + py * uy;
+        auto v = px * vx + py * vy;
+
+        return u >= 0 && u <= ux * ux + uy * uy && v >= 0 && v <= vx * vx + vy * vy;
+    }
+
+    auto area() -> double
+    {
+        if (!rectangular()) {
+            return Base::area();
+        }
+
+        return std::abs((second.X.value - first.X.value) * (fourth.Y.value - first.Y.value) -
+                        (second.Y.value - first.Y.value) * (fourth.X.value - first.X.value));
+    }
+
+    auto perimeter() -> double
+    {
+        if (!rectangular()) {
+            return Base::perimeter();
+        }
+
+        return 2 * (first.distance(second) + first.distance(fourth));
+    }
+
+private:
+    // Right angle at the first vertex and opposite sides parallel.
+    auto rectangular() const -> bool
+    {
+        auto ux = second.X.value - first.X.value, uy = second.Y.value - first.Y.value;
+        auto vx = fourth.X.value - first.X.value, vy = fourth.Y.value - first.Y.value;
+        auto uu = ux * ux + uy * uy;
+        auto vv = vx * vx + vy * vy;
+        auto dot = ux * vx + uy * vy;
+        auto epsilon = 1e-9 * (std::abs(ux) + std::abs(uy) + std::abs(vx) + std::abs(vy));
+
+        return uu > 0 && vv > 0 && dot * dot <= 1e-18 * uu * vv &&
+               std::abs(second.X.value + vx - third.X.value) <= epsilon &&
+               std::abs(second.Y.value + vy - third.Y.value) <= epsilon;
+    }
 };
 
 // Regular Polygon (x,y)...(xN,yN)
@@ -1354,6 +1954,16 @@ public:
 
         return points();
     }
+
+    using Base::contains;
+
+    auto contains(const Point &point) -> bool
+    {
+        auto dx = point.X.value - center.X.value;
+        auto dy = point.Y.value - center.Y.value;
+
+        return dx * dx + dy * dy <= horizontalRadius * horizontalRadius;
+    }
 };
 
 // Irregular Polygon (x,y)...(xN,yN)
@@ -1385,6 +1995,2285 @@ public:
     ~IrregularPolygon() = default;
 };
 
+// Integer grid : fixed-point coordinates with snap rounding.
+// step : size of the grid cell, the coordinates are multiples of step.
+// The predicates and areas are exact for coordinates below 2^30 cells in absolute value :
+// the differences stay below 2^31 and their products below 2^62, on 64 bits. Beyond, the
+// results are undefined.
+class Grid {
+
+public:
+    using Cell = std::array<long long, 2>;
+
+    double step{1.0};
+
+    Grid() = default;
+
+    explicit Grid(const double &step) : step(step > 0 ? step : 1.0) {}
+
+    ~Grid() = default;
+
+    // Nearest grid node.
+    auto snap(const Point &point) const -> Cell
+    {
+        return {std::llround(point.X.value / step), std::llround(point.Y.value / step)};
+    }
+
+    // Snap points, removing the duplicates created by rounding.
+    auto snap(const std::vector<Point> &points) const -> std::vector<Cell>
+    {
+        std::vector<Cell> result;
+        result.reserve(points.size());
+        for (const auto &point : points) {
+            auto cell = snap(point);
+            if (result.empty() || result.back() != cell) {
+                result.push_back(cell);
+            }
+        }
+        while (result.size() > 1 && result.back() == result.front()) {
+            result.pop_back();
+        }
+
+        return result;
+    }
+
+    // Snap polygon vertices.
+    auto snap(Base base) const -> std::vector<Cell>
+    {
+        return snap(base.points());
+    }
+
+    // Grid node to Point.
+    auto point(const Cell &cell) const -> Point
+    {
+        return {static_cast<double>(cell[0]) * step, static_cast<double>(cell[1]) * step};
+    }
+
+    // Grid nodes to Points.
+    auto points(const std::vector<Cell> &cells) const -> std::vector<Point>
+    {
+        std::vector<Point> result;
+        result.reserve(cells.size());
+        for (const auto &cell : cells) {
+            result.push_back(point(cell));
+        }
+
+        return result;
+    }
+
+    // Returns 1 if counterclockwise, -1 if clockwise and 0 if collinear.
+    static auto orientation(const Cell &a, const Cell &b, const Cell &c) -> int
+    {
+        auto cross = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+
+        return (cross > 0) - (cross < 0);
+    }
+
+    // Checks if the point is on the segment (a,b).
+    static auto onSegment(const Cell &a, const Cell &b, const Cell &point) -> bool
+    {
+        return orientation(a, b, point) == 0 &&
+               point[0] >= std::min(a[0], b[0]) && point[0] <= std::max(a[0], b[0]) &&
+               point[1] >= std::min(a[1], b[1]) && point[1] <= std::max(a[1], b[1]);
+    }
+
+    // Checks if the segments (a,b) and (c,d) touch or cross.
+    static auto intersect(const Cell &a, const Cell &b, const Cell &c, const Cell &d) -> bool
+    {
+        auto o1 = orientation(a, b, c);
+        auto o2 = orientation(a, b, d);
+        auto o3 = orientation(c, d, a);
+        auto o4 = orientation(c, d, b);
+
+        if (o1 != o2 && o3 != o4) {
+            return true;
+        }
+
+        return onSegment(a, b, c) || onSegment(a, b, d) || onSegment(c, d, a) || onSegment(c, d, b);
+    }
+
+    // Polygon contains point, the boundary included.
+    static auto contains(const std::vector<Cell> &polygon, const Cell &point) -> bool
+    {
+        bool result = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const auto &a = polygon[j];
+            const auto &b = polygon[i];
+            if (onSegment(a, b, point)) {
+                return true;
+            }
+            if ((a[1] > point[1]) != (b[1] > point[1])) {
+                auto side = orientation(a, b, point);
+                if ((b[1] > a[1] && side > 0) || (b[1] < a[1] && side < 0)) {
+                    result = !result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Twice the signed area (exact).
+    // The partial sums may overflow : they wrap around (unsigned), the result fits on 64 bits.
+    static auto doubleArea(const std::vector<Cell> &polygon) -> long long
+    {
+        unsigned long long result = 0;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            result += static_cast<unsigned long long>(polygon[j][0] * polygon[i][1] - polygon[i][0] * polygon[j][1]);
+        }
+
+        return static_cast<long long>(result);
+    }
+};
+
+// Static k-d tree over a set of points.
+// The queries return indices of the original vector.
+class KDTree {
+
+    struct Item {
+        std::array<double, 2> point;
+        size_t index;
+    };
+
+    // Compact buffer in tree order : coordinates and original indices.
+    std::vector<Item> m_items;
+
+    // Balanced tree : the median of each range is the node.
+    void build(size_t begin, size_t end, int axis)
+    {
+        if (end - begin < 2) {
+            return;
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        std::nth_element(m_items.begin() + static_cast<long>(begin),
+                         m_items.begin() + static_cast<long>(middle),
+                         m_items.begin() + static_cast<long>(end),
+        [axis](const Item & a, const Item & b) {
+            return a.point[axis] < b.point[axis];
+        });
+
+        build(begin, middle, 1 - axis);
+        build(middle + 1, end, 1 - axis);
+    }
+
+    static auto squaredDistance(const std::array<double, 2> &a, const double &x, const double &y) -> double
+    {
+        return (a[0] - x) * (a[0] - x) + (a[1] - y) * (a[1] - y);
+    }
+
+    // Max heap with the k nearest candidates : {squared distance, tree position}.
+    void nearest(size_t begin, size_t end, int axis, const double &x, const double &y, unsigned k,
+                 std::vector<std::pair<double, size_t> > &heap) const
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        auto d = squaredDistance(m_items[middle].point, x, y);
+        if (heap.size() < k) {
+            heap.emplace_back(d, middle);
+            std::push_heap(heap.begin(), heap.end());
+        }
+        else if (d < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = {d, middle};
+            std::push_heap(heap.begin(), heap.end());
+        }
+
+        auto delta = (axis == 0 ? x : y) - m_items[middle].point[axis];
+        auto nearSide = delta < 0;
+        nearest(nearSide ? begin : middle + 1, nearSide ? middle : end, 1 - axis, x, y, k, heap);
+        if (heap.size() < k || delta * delta < heap.front().first) {
+            nearest(nearSide ? middle + 1 : begin, nearSide ? end : middle, 1 - axis, x, y, k, heap);
+        }
+    }
+
+    void range(size_t begin, size_t end, int axis, const std::array<double, 4> &box,
+               std::vector<size_t> &result) const
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        const auto &point = m_items[middle].point;
+        if (point[0] >= box[0] && point[1] >= box[1] && point[0] <= box[2] && point[1] <= box[3]) {
+            result.push_back(m_items[middle].index);
+        }
+        if (box[axis] <= point[axis]) {
+            range(begin, middle, 1 - axis, box, result);
+        }
+        if (box[axis + 2] >= point[axis]) {
+            range(middle + 1, end, 1 - axis, box, result);
+        }
+    }
+
+    void radius(size_t begin, size_t end, int axis, const double &x, const double &y, const double &limit,
+                std::vector<size_t> &result) const
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        if (squaredDistance(m_items[middle].point, x, y) <= limit) {
+            result.push_back(m_items[middle].index);
+        }
+        auto delta = (axis == 0 ? x : y) - m_items[middle].point[axis];
+        if (delta <= 0 || delta * delta <= limit) {
+            radius(begin, middle, 1 - axis, x, y, limit, result);
+        }
+        if (delta >= 0 || delta * delta <= limit) {
+            radius(middle + 1, end, 1 - axis, x, y, limit, result);
+        }
+    }
+
+    // Runs the query for each point, splitting the points between threads.
+    template<typename Query>
+    static auto batch(const std::vector<Point> &points, unsigned threads, Query query)
+        -> std::vector<std::vector<size_t> >
+    {
+        std::vector<std::vector<size_t> > result(points.size());
+        threads = threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+        auto chunk = (points.size() + threads - 1) / threads;
+
+        std::vector<std::thread> workers;
+        for (size_t begin = 0; begin < points.size(); begin += chunk) {
+            auto end = std::min(points.size(), begin + chunk);
+            workers.emplace_back([&, begin, end]() {
+                for (auto i = begin; i < end; ++i) {
+                    result[i] = query(points[i]);
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        return result;
+    }
+
+public:
+    KDTree() = default;
+
+    explicit KDTree(const std::vector<Point> &points)
+    {
+        setup(points);
+    }
+
+    ~KDTree() = default;
+
+    // Builds the tree, O(n log n).
+    void setup(const std::vector<Point> &points)
+    {
+        m_items.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            m_items[i] = {{points[i].X.value, points[i].Y.value}, i};
+        }
+
+        build(0, m_items.size(), 0);
+    }
+
+    auto size() const -> size_t
+    {
+        return m_items.size();
+    }
+
+    // Indices of the k nearest points, closest first. Empty if k = 0.
+    auto nearest(const Point &point, unsigned k = 1) const -> std::vector<size_t>
+    {
+        if (k == 0) {
+            return {};
+        }
+
+        std::vector<std::pair<double, size_t> > heap;
+        heap.reserve(k);
+        nearest(0, m_items.size(), 0, point.X.value, point.Y.value, k, heap);
+        std::sort_heap(heap.begin(), heap.end());
+
+        std::vector<size_t> result;
+        result.reserve(heap.size());
+        for (const auto &item : heap) {
+            result.push_back(m_items[item.second].index);
+        }
+
+        return result;
+    }
+
+    // Indices of the points at distance <= radius.
+    auto radius(const Point &point, const double &radius) const -> std::vector<size_t>
+    {
+        std::vector<size_t> result;
+        this->radius(0, m_items.size(), 0, point.X.value, point.Y.value, radius * radius, result);
+
+        return result;
+    }
+
+    // Indices of the points inside the rectangle (min, max).
+    auto range(const Point &min, const Point &max) const -> std::vector<size_t>
+    {
+        std::vector<size_t> result;
+        range(0, m_items.size(), 0, {min.X.value, min.Y.value, max.X.value, max.Y.value}, result);
+
+        return result;
+    }
+
+    // Batch : k nearest for each point.
+    // Threads : number of threads, 0 uses the hardware concurrency.
+    auto nearest(const std::vector<Point> &points, unsigned k, unsigned threads = 0) const
+        -> std::vector<std::vector<size_t> >
+    {
+        return batch(points, threads, [this, k](const Point & point) {
+            return nearest(point, k);
+        });
+    }
+
+    // Batch : points at distance <= radius for each point.
+    // Threads : number of threads, 0 uses the hardware concurrency.
+    auto radius(const std::vector<Point> &points, const double &radius, unsigned threads = 0) const
+        -> std::vector<std::vector<size_t> >
+    {
+        return batch(points, threads, [this, radius](const Point & point) {
+            return this->radius(point, radius);
+        });
+    }
+};
+
+// Bounding volume hierarchy over the edges of a polygon.
+// Closest point and signed distance to the outline.
+class SegmentBVH {
+
+    struct Segment {
+        double x0{0}, y0{0}, x1{0}, y1{0};
+        size_t index{0};
+    };
+
+    // Box {min X, min Y, max X, max Y}, leaf range and children.
+    struct Node {
+        std::array<double, 4> box{0, 0, 0, 0};
+        size_t begin{0}, end{0};
+        int left{-1}, right{-1};
+    };
+
+    std::vector<Segment> m_segments;
+    std::vector<Node> m_nodes;
+    bool m_closed{false};
+
+    auto build(size_t begin, size_t end) -> int
+    {
+        Node node;
+        node.begin = begin;
+        node.end = end;
+        node.box = {
+            std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()
+        };
+        for (auto i = begin; i < end; ++i) {
+            const auto &s = m_segments[i];
+            node.box[0] = std::min({node.box[0], s.x0, s.x1});
+            node.box[1] = std::min({node.box[1], s.y0, s.y1});
+            node.box[2] = std::max({node.box[2], s.x0, s.x1});
+            node.box[3] = std::max({node.box[3], s.y0, s.y1});
+        }
+
+        auto id = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(node);
+
+        const size_t leafSize = 4;
+        if (end - begin > leafSize) {
+            // Split at the median of the centroids, on the wider axis.
+            bool axisX = node.box[2] - node.box[0] >= node.box[3] - node.box[1];
+            auto middle = begin + (end - begin) / 2;
+            std::nth_element(m_segments.begin() + static_cast<long>(begin),
+                             m_segments.begin() + static_cast<long>(middle),
+                             m_segments.begin() + static_cast<long>(end),
+            [axisX](const Segment & a, const Segment & b) {
+                return axisX ? a.x0 + a.x1 < b.x0 + b.x1 : a.y0 + a.y1 < b.y0 + b.y1;
+            });
+            auto left = build(begin, middle);
+            auto right = build(middle, end);
+            m_nodes[id].left = left;
+            m_nodes[id].right = right;
+        }
+
+        return id;
+    }
+
+    static auto boxDistance(const std::array<double, 4> &box, const double &x, const double &y) -> double
+    {
+        auto dx = std::max({box[0] - x, 0.0, x - box[2]});
+        auto dy = std::max({box[1] - y, 0.0, y - box[3]});
+
+        return dx * dx + dy * dy;
+    }
+
+    // Squared distance and closest point on the segment.
+    static auto segmentDistance(const Segment &s, const double &x, const double &y) -> std::array<double, 3>
+    {
+        auto dx = s.x1 - s.x0;
+        auto dy = s.y1 - s.y0;
+        auto length = dx * dx + dy * dy;
+        auto t = length > 0 ? std::clamp(((x - s.x0) * dx + (y - s.y0) * dy) / length, 0.0, 1.0) : 0.0;
+        auto px = s.x0 + t * dx;
+        auto py = s.y0 + t * dy;
+
+        return {(x - px) * (x - px) + (y - py) * (y - py), px, py};
+    }
+
+public:
+    SegmentBVH() = default;
+
+    explicit SegmentBVH(Base base)
+    {
+        setup(base);
+    }
+
+    ~SegmentBVH() = default;
+
+    // Builds the hierarchy from the edges, closed if there are three or more vertices.
+    void setup(Base base)
+    {
+        auto points = base.points();
+        m_segments.clear();
+        m_nodes.clear();
+        m_closed = points.size() > 2;
+
+        auto edges = m_closed ? points.size() : points.size() - std::min<size_t>(points.size(), 1);
+        for (size_t i = 0; i < edges; ++i) {
+            const auto &a = points[i];
+            const auto &b = points[(i + 1) % points.size()];
+            m_segments.push_back({a.X.value, a.Y.value, b.X.value, b.Y.value, i});
+        }
+
+        if (!m_segments.empty()) {
+            build(0, m_segments.size());
+        }
+    }
+
+    // Builds the hierarchy from the edges of several closed polygons, numbered in order.
+    // Polygons with less than three vertices are ignored.
+    void setup(std::vector<Base> polygons)
+    {
+        m_segments.clear();
+        m_nodes.clear();
+        m_closed = true;
+
+        size_t index = 0;
+        for (auto &base : polygons) {
+            auto points = base.points();
+            if (points.size() < 3) {
+                continue;
+            }
+            for (size_t i = 0; i < points.size(); ++i) {
+                const auto &a = points[i];
+                const auto &b = points[(i + 1) % points.size()];
+                m_segments.push_back({a.X.value, a.Y.value, b.X.value, b.Y.value, index++});
+            }
+        }
+
+        if (!m_segments.empty()) {
+            build(0, m_segments.size());
+        }
+    }
+
+    auto empty() const -> bool
+    {
+        return m_segments.empty();
+    }
+
+    // Visits the edges that the segment (a,b) may touch : visit(edge index, first point, second point).
+    // Nodes away from the segment line are skipped. The visit returns false to stop.
+    template<typename Visit>
+    void crossing(const Point &a, const Point &b, Visit visit) const
+    {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        auto dx = b.X.value - a.X.value;
+        auto dy = b.Y.value - a.Y.value;
+        std::array<double, 4> box{
+            std::min(a.X.value, b.X.value), std::min(a.Y.value, b.Y.value),
+            std::max(a.X.value, b.X.value), std::max(a.Y.value, b.Y.value)
+        };
+        auto away = [&](const double &x0, const double &y0, const double &x1, const double &y1) {
+            if (x1 < box[0] || x0 > box[2] || y1 < box[1] || y0 > box[3]) {
+                return true;
+            }
+            // Every corner on the same side of the line.
+            std::array<double, 4> sides{
+                dx * (y0 - a.Y.value) - dy * (x0 - a.X.value), dx * (y0 - a.Y.value) - dy * (x1 - a.X.value),
+                dx * (y1 - a.Y.value) - dy * (x0 - a.X.value), dx * (y1 - a.Y.value) - dy * (x1 - a.X.value)
+            };
+            return std::all_of(sides.begin(), sides.end(), [](double side) {
+                return side > 0;
+            }) || std::all_of(sides.begin(), sides.end(), [](double side) {
+                return side < 0;
+            });
+        };
+
+        // Median splits : the depth stays below 64.
+        std::array<int, 64> stack{0};
+        size_t size = 1;
+        while (size > 0) {
+            const auto &node = m_nodes[stack[--size]];
+            if (away(node.box[0], node.box[1], node.box[2], node.box[3])) {
+                continue;
+            }
+            if (node.left < 0) {
+                for (auto i = node.begin; i < node.end; ++i) {
+                    const auto &s = m_segments[i];
+                    if (!away(std::min(s.x0, s.x1), std::min(s.y0, s.y1), std::max(s.x0, s.x1), std::max(s.y0, s.y1)) &&
+                        !visit(s.index, Point(s.x0, s.y0), Point(s.x1, s.y1))) {
+                        return;
+                    }
+                }
+                continue;
+            }
+            stack[size++] = node.left;
+            stack[size++] = node.right;
+        }
+    }
+
+    // Closest point on the outline, distance and edge index (edge i : vertex i to i + 1).
+    // Returns Point(0,0), max and 0 if empty.
+    auto closest(const Point &point) const -> std::tuple<Point, double, size_t>
+    {
+        auto x = point.X.value;
+        auto y = point.Y.value;
+        std::array<double, 3> best{std::numeric_limits<double>::max(), 0, 0};
+        size_t edge = 0;
+        if (m_nodes.empty()) {
+            return {Point(), best[0], edge};
+        }
+
+        std::vector<int> stack{0};
+        while (!stack.empty()) {
+            const auto &node = m_nodes[stack.back()];
+            stack.pop_back();
+            if (boxDistance(node.box, x, y) >= best[0]) {
+                continue;
+            }
+            if (node.left < 0) {
+                for (auto i = node.begin; i < node.end; ++i) {
+                    auto result = segmentDistance(m_segments[i], x, y);
+                    if (result[0] < best[0]) {
+                        best = result;
+                        edge = m_segments[i].index;
+                    }
+                }
+                continue;
+            }
+            // Nearest child on top of the stack.
+            auto left = boxDistance(m_nodes[node.left].box, x, y);
+            auto right = boxDistance(m_nodes[node.right].box, x, y);
+            stack.push_back(left < right ? node.right : node.left);
+            stack.push_back(left < right ? node.left : node.right);
+        }
+
+        return {Point(best[1], best[2]), std::sqrt(best[0]), edge};
+    }
+
+    // Distance to the outline.
+    auto distance(const Point &point) const -> double
+    {
+        return std::get<1>(closest(point));
+    }
+
+    // Polygon contains point (even-odd rule).
+    auto contains(const Point &point) const -> bool
+    {
+        if (!m_closed) {
+            return false;
+        }
+
+        auto x = point.X.value;
+        auto y = point.Y.value;
+        bool result = false;
+        std::vector<int> stack{0};
+        while (!stack.empty()) {
+            const auto &node = m_nodes[stack.back()];
+            stack.pop_back();
+            // Horizontal ray to the right.
+            if (y < node.box[1] || y > node.box[3] || x > node.box[2]) {
+                continue;
+            }
+            if (node.left < 0) {
+                for (auto i = node.begin; i < node.end; ++i) {
+                    const auto &s = m_segments[i];
+                    if ((s.y0 > y) != (s.y1 > y) && x < (s.x1 - s.x0) * (y - s.y0) / (s.y1 - s.y0) + s.x0) {
+                        result = !result;
+                    }
+                }
+                continue;
+            }
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+
+        return result;
+    }
+
+    // Signed distance : negative inside the polygon.
+    auto signedDistance(const Point &point) const -> double
+    {
+        auto d = distance(point);
+
+        return contains(point) ? -d : d;
+    }
+
+    // Batch : signed distances sampled on a grid, row by row.
+    // Origin : first sample, step : distance between samples,
+    // threads : number of threads, 0 uses the hardware concurrency.
+    auto signedDistance(const Point &origin, size_t columns, size_t rows, const double &step,
+                        unsigned threads = 0) const -> std::vector<double>
+    {
+        std::vector<double> result(columns * rows, 0);
+        threads = threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+        auto chunk = (rows + threads - 1) / threads;
+
+        std::vector<std::thread> workers;
+        for (size_t begin = 0; begin < rows; begin += chunk) {
+            auto end = std::min(rows, begin + chunk);
+            workers.emplace_back([&, begin, end]() {
+                for (auto row = begin; row < end; ++row) {
+                    for (size_t column = 0; column < columns; ++column) {
+                        result[row * columns + column] = signedDistance(origin + Point(column * step, row * step));
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        return result;
+    }
+};
+
+// Signed distance field sampled on a grid (negative inside).
+// Union of the shapes, values stored row by row.
+class DistanceField {
+
+    // Signed distance to the ellipse (iterative, trigonometry free).
+    static auto ellipseDistance(const Ellipse &ellipse, const double &x, const double &y) -> double
+    {
+        auto a = ellipse.horizontalRadius;
+        auto b = ellipse.verticalRadius;
+        auto px = std::abs(x - ellipse.center.X.value);
+        auto py = std::abs(y - ellipse.center.Y.value);
+
+        if (a == b) {
+            return std::hypot(px, py) - a;
+        }
+
+        double tx = std::numbers::sqrt2 / 2;
+        double ty = std::numbers::sqrt2 / 2;
+        const int iterations = 4;
+        for (int i = 0; i < iterations; ++i) {
+            auto ex = (a * a - b * b) * tx * tx * tx / a;
+            auto ey = (b * b - a * a) * ty * ty * ty / b;
+            auto r = std::hypot(a * tx - ex, b * ty - ey);
+            auto q = std::hypot(px - ex, py - ey);
+            if (q == 0) {
+                break;
+            }
+            tx = std::clamp(((px - ex) * r / q + ex) / a, 0.0, 1.0);
+            ty = std::clamp(((py - ey) * r / q + ey) / b, 0.0, 1.0);
+            auto t = std::hypot(tx, ty);
+            tx /= t;
+            ty /= t;
+        }
+
+        auto d = std::hypot(px - a * tx, py - b * ty);
+        auto inside = (px * px) / (a * a) + (py * py) / (b * b) <= 1;
+
+        return inside ? -d : d;
+    }
+
+    // Squared distance transform in one dimension (lower envelope of parabolas).
+    static void transform(std::vector<double> &f, std::vector<double> &d, std::vector<size_t> &v, std::vector<double> &z)
+    {
+        const auto n = f.size();
+        const double infinity = std::numeric_limits<double>::max();
+        size_t k = 0;
+        v[0] = 0;
+        z[0] = -infinity;
+        z[1] = infinity;
+        auto intersection = [&f, &v](size_t q, size_t k) {
+            auto r = static_cast<double>(v[k]);
+            auto dq = static_cast<double>(q);
+            return ((f[q] + dq * dq) - (f[v[k]] + r * r)) / (2 * dq - 2 * r);
+        };
+        for (size_t q = 1; q < n; ++q) {
+            auto s = intersection(q, k);
+            while (s <= z[k]) {
+                k--;
+                s = intersection(q, k);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = infinity;
+        }
+        k = 0;
+        for (size_t q = 0; q < n; ++q) {
+            while (z[k + 1] < static_cast<double>(q)) {
+                k++;
+            }
+            auto r = static_cast<double>(q) - static_cast<double>(v[k]);
+            d[q] = r * r + f[v[k]];
+        }
+    }
+
+    // Squared distance of each cell to the nearest feature cell.
+    static auto transform(const std::vector<bool> &feature, size_t columns, size_t rows) -> std::vector<double>
+    {
+        const double infinity = 1e20;
+        std::vector<double> grid(columns * rows);
+        for (size_t i = 0; i < grid.size(); ++i) {
+            grid[i] = feature[i] ? 0 : infinity;
+        }
+
+        auto size = std::max(columns, rows);
+        std::vector<double> f(size), d(size), z(size + 1);
+        std::vector<size_t> v(size);
+
+        // Columns
+        f.resize(rows);
+        d.resize(rows);
+        for (size_t x = 0; x < columns; ++x) {
+            for (size_t y = 0; y < rows; ++y) {
+                f[y] = grid[y * columns + x];
+            }
+            transform(f, d, v, z);
+            for (size_t y = 0; y < rows; ++y) {
+                grid[y * columns + x] = d[y];
+            }
+        }
+
+        // Rows
+        f.resize(columns);
+        d.resize(columns);
+        for (size_t y = 0; y < rows; ++y) {
+            std::copy(grid.begin() + static_cast<long>(y * columns),
+                      grid.begin() + static_cast<long>((y + 1) * columns), f.begin());
+            transform(f, d, v, z);
+            std::copy(d.begin(), d.end(), grid.begin() + static_cast<long>(y * columns));
+        }
+
+        return grid;
+    }
+
+public:
+    Point origin{0, 0};
+    size_t columns{0};
+    size_t rows{0};
+    double step{1.0};
+    std::vector<float> values;
+
+    DistanceField() = default;
+
+    // Origin : first sample, step : distance between samples.
+    DistanceField(const Point &origin, size_t columns, size_t rows, const double &step)
+        : origin(origin), columns(columns), rows(rows), step(step), values(columns * rows, 0) {}
+
+    ~DistanceField() = default;
+
+    // Sample position.
+    auto position(size_t column, size_t row) const -> Point
+    {
+        return origin + Point(static_cast<double>(column) * step, static_cast<double>(row) * step);
+    }
+
+    auto at(size_t column, size_t row) const -> float
+    {
+        return values[row * columns + column];
+    }
+
+    // Exact distances : analytic for ellipses, edges for polygons.
+    // The grid is divided into tiles shared between threads.
+    // Threads : number of threads, 0 uses the hardware concurrency.
+    void generate(const std::vector<Ellipse> &ellipses, const std::vector<Base> &polygons, unsigned threads = 0)
+    {
+        values.assign(columns * rows, std::numeric_limits<float>::max());
+
+        std::vector<SegmentBVH> trees;
+        for (const auto &polygon : polygons) {
+            trees.emplace_back(polygon);
+        }
+
+        const size_t tile = 64;
+        auto tilesX = (columns + tile - 1) / tile;
+        auto tilesY = (rows + tile - 1) / tile;
+        std::atomic<size_t> next{0};
+
+        auto worker = [&]() {
+            for (auto t = next++; t < tilesX * tilesY; t = next++) {
+                auto x0 = (t % tilesX) * tile;
+                auto y0 = (t / tilesX) * tile;
+                for (auto row = y0; row < std::min(rows, y0 + tile); ++row) {
+                    for (auto column = x0; column < std::min(columns, x0 + tile); ++column) {
+                        auto p = position(column, row);
+                        auto d = std::numeric_limits<double>::max();
+                        for (const auto &ellipse : ellipses) {
+                            d = std::min(d, ellipseDistance(ellipse, p.X.value, p.Y.value));
+                        }
+                        for (const auto &tree : trees) {
+                            if (!tree.empty()) {
+                                d = std::min(d, tree.signedDistance(p));
+                            }
+                        }
+                        values[row * columns + column] = static_cast<float>(d);
+                    }
+                }
+            }
+        };
+
+        threads = threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back(worker);
+        }
+        for (auto &item : workers) {
+            item.join();
+        }
+    }
+
+    // Approximate distances from the inside mask (row by row), linear time.
+    // Values : distance to the nearest inside sample, negative distance to
+    // the nearest outside sample for the inside ones.
+    void generate(const std::vector<bool> &inside)
+    {
+        if (inside.size() != columns * rows) {
+            values.clear();
+            return;
+        }
+
+        std::vector<bool> outside(inside.size());
+        bool empty = true, full = true;
+        for (size_t i = 0; i < inside.size(); ++i) {
+            outside[i] = !inside[i];
+            empty = empty && !inside[i];
+            full = full && inside[i];
+        }
+        values.assign(columns * rows, std::numeric_limits<float>::max());
+        if (empty || full) {
+            return;
+        }
+
+        auto toInside = transform(inside, columns, rows);
+        auto toOutside = transform(outside, columns, rows);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<float>(inside[i] ? -std::sqrt(toOutside[i]) * step : std::sqrt(toInside[i]) * step);
+        }
+    }
+};
+
+// Path finding around polygon obstacles.
+// Visibility graph between the convex vertices of the obstacles and A* search.
+// Only the segments tangent to the obstacles at their vertices are kept (a shortest path
+// bends around the obstacles), unless an obstacle crosses itself : the path may then bend at
+// the crossings, which are not nodes. The visibility tests go through a hierarchy of the edges.
+class Navigation {
+
+    struct Obstacle {
+        std::vector<Point> vertices;
+        std::array<double, 4> box{0, 0, 0, 0};
+    };
+
+    std::vector<Obstacle> m_obstacles;
+    SegmentBVH m_edges;
+    std::vector<size_t> m_owners;                   // Obstacle of each edge.
+    std::vector<Point> m_nodes;
+    std::vector<std::array<Point, 2> > m_neighbours; // Previous and next vertex of each node.
+    bool m_crossing{false};                         // An obstacle crosses itself.
+    std::vector<std::vector<std::pair<size_t, double> > > m_graph;
+
+    static auto cross(const Point &a, const Point &b, const Point &c) -> double
+    {
+        return (b.X.value - a.X.value) * (c.Y.value - a.Y.value) - (b.Y.value - a.Y.value) * (c.X.value - a.X.value);
+    }
+
+    // Strictly inside the polygon (even-odd rule).
+    static auto inside(const std::vector<Point> &polygon, const Point &point) -> bool
+    {
+        bool result = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const auto &a = polygon[j];
+            const auto &b = polygon[i];
+            if (cross(a, b, point) == 0 &&
+                point.X.value >= std::min(a.X.value, b.X.value) && point.X.value <= std::max(a.X.value, b.X.value) &&
+                point.Y.value >= std::min(a.Y.value, b.Y.value) && point.Y.value <= std::max(a.Y.value, b.Y.value)) {
+                return false;   // On the boundary.
+            }
+            if ((a.Y.value > point.Y.value) != (b.Y.value > point.Y.value) &&
+                point.X.value < (b.X.value - a.X.value) * (point.Y.value - a.Y.value) / (b.Y.value - a.Y.value) + a.X.value) {
+                result = !result;
+            }
+        }
+
+        return result;
+    }
+
+    auto blocked(const Point &point) const -> bool
+    {
+        for (const auto &obstacle : m_obstacles) {
+            if (point.X.value > obstacle.box[0] && point.Y.value > obstacle.box[1] &&
+                point.X.value < obstacle.box[2] && point.Y.value < obstacle.box[3] &&
+                inside(obstacle.vertices, point)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // The line from the point to the node leaves the node's obstacle on one side.
+    auto tangent(size_t node, const Point &point) const -> bool
+    {
+        if (m_crossing) {
+            return true;
+        }
+        const auto &vertex = m_nodes[node];
+
+        return cross(point, vertex, m_neighbours[node][0]) * cross(point, vertex, m_neighbours[node][1]) >= 0;
+    }
+
+public:
+    // Reusable search memory, one for each thread.
+    struct Query {
+        std::vector<double> cost;
+        std::vector<size_t> parent;
+        std::vector<unsigned> generation;
+        std::vector<std::pair<double, size_t> > heap;
+        std::vector<double> toGoal;         // Length of the link to the goal, negative if hidden.
+        std::vector<unsigned> linked;       // Generation of the link to the goal.
+        unsigned current{0};
+    };
+
+    Navigation() = default;
+
+    explicit Navigation(const std::vector<Base> &obstacles)
+    {
+        setup(obstacles);
+    }
+
+    ~Navigation() = default;
+
+    // Builds the visibility graph.
+    void setup(std::vector<Base> obstacles)
+    {
+        m_obstacles.clear();
+        m_owners.clear();
+        m_nodes.clear();
+        m_neighbours.clear();
+        m_graph.clear();
+        m_crossing = false;
+
+        for (auto &base : obstacles) {
+            auto [min, max] = base.boundingBox();
+            auto points = base.points();
+            if (points.size() < 3) {
+                continue;
+            }
+            m_obstacles.push_back({points, {min.X.value, min.Y.value, max.X.value, max.Y.value}});
+            m_owners.insert(m_owners.end(), points.size(), m_obstacles.size() - 1);
+
+            // Convex vertices : the reflex ones are never on a shortest path.
+            double area = 0;
+            for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+                area += points[j].X.value * points[i].Y.value - points[i].X.value * points[j].Y.value;
+            }
+            for (size_t i = 0; i < points.size(); ++i) {
+                const auto &previous = points[(i + points.size() - 1) % points.size()];
+                const auto &next = points[(i + 1) % points.size()];
+                if (cross(previous, points[i], next) * area > 0) {
+                    m_nodes.push_back(points[i]);
+                    m_neighbours.push_back({previous, next});
+                }
+            }
+        }
+        m_edges.setup(obstacles);
+
+        for (size_t k = 0; k < m_obstacles.size() && !m_crossing; ++k) {
+            const auto &vertices = m_obstacles[k].vertices;
+            for (size_t i = 0, j = vertices.size() - 1; i < vertices.size() && !m_crossing; j = i++) {
+                const auto &a = vertices[j];
+                const auto &b = vertices[i];
+                m_edges.crossing(a, b, [&](size_t edge, const Point &c, const Point &d) {
+                    if (m_owners[edge] != k) {
+                        return true;
+                    }
+                    auto o1 = cross(a, b, c);
+                    auto o2 = cross(a, b, d);
+                    auto o3 = cross(c, d, a);
+                    auto o4 = cross(c, d, b);
+                    m_crossing = ((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0));
+                    return !m_crossing;
+                });
+            }
+        }
+
+        m_graph.resize(m_nodes.size());
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            if (blocked(m_nodes[i])) {
+                continue;
+            }
+            for (size_t j = i + 1; j < m_nodes.size(); ++j) {
+                if (tangent(i, m_nodes[j]) && tangent(j, m_nodes[i]) && visible(m_nodes[i], m_nodes[j])) {
+                    auto d = m_nodes[i].distance(m_nodes[j]);
+                    m_graph[i].emplace_back(j, d);
+                    m_graph[j].emplace_back(i, d);
+                }
+            }
+        }
+    }
+
+    // Checks if the segment (a,b) does not cross any obstacle.
+    // Touching the boundary is allowed.
+    auto visible(const Point &a, const Point &b) const -> bool
+    {
+        auto length = a.distance(b);
+        bool result = true;
+        // Obstacles touching the line at the ends : the segment may be a diagonal inside them.
+        std::array<size_t, 4> touching{};
+        size_t count = 0;
+        bool many = false;
+        // Obstacle having the segment as an edge : it is on its boundary.
+        auto along = m_obstacles.size();
+
+        m_edges.crossing(a, b, [&](size_t edge, const Point &c, const Point &d) {
+            const auto &vertices = m_obstacles[m_owners[edge]].vertices;
+            if ((c.equal(a) && d.equal(b)) || (c.equal(b) && d.equal(a))) {
+                along = m_owners[edge];
+                return true;
+            }
+            auto o1 = cross(a, b, c);
+            auto o2 = cross(a, b, d);
+            auto o3 = cross(c, d, a);
+            auto o4 = cross(c, d, b);
+            // Proper crossing.
+            if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0))) {
+                result = false;
+                return false;
+            }
+            // Through a vertex : check both sides of it.
+            if (o2 == 0 && length > 0 && !d.equal(a) && !d.equal(b)) {
+                auto t = ((d.X.value - a.X.value) * (b.X.value - a.X.value) +
+                          (d.Y.value - a.Y.value) * (b.Y.value - a.Y.value)) / (length * length);
+                if (t > 0 && t < 1) {
+                    auto epsilon = 1e-7;
+                    auto direction = (b - a) * (1.0 / length);
+                    if (inside(vertices, d + direction * epsilon) || inside(vertices, d - direction * epsilon)) {
+                        result = false;
+                        return false;
+                    }
+                }
+            }
+            if (o3 == 0 || o4 == 0) {
+                auto owner = m_owners[edge];
+                if (std::find(touching.begin(), touching.begin() + count, owner) == touching.begin() + count) {
+                    if (count < touching.size()) {
+                        touching[count++] = owner;
+                    }
+                    else {
+                        many = true;
+                    }
+                }
+            }
+            return true;
+        });
+        if (!result) {
+            return false;
+        }
+
+        // Diagonal between two boundary points of the same obstacle.
+        auto middle = (a + b) * 0.5;
+        if (many) {
+            for (size_t i = 0; i < m_obstacles.size(); ++i) {
+                if (i != along && inside(m_obstacles[i].vertices, middle)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (touching[i] != along && inside(m_obstacles[touching[i]].vertices, middle)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Shortest path from start to goal, empty if there is no path.
+    auto path(const Point &start, const Point &goal, Query &query) const -> std::vector<Point>
+    {
+        if (blocked(start) || blocked(goal)) {
+            return {};
+        }
+        if (visible(start, goal)) {
+            return {start, goal};
+        }
+
+        // Nodes : obstacle vertices, start (n) and goal (n + 1).
+        const auto n = m_nodes.size();
+        const auto startIndex = n;
+        const auto goalIndex = n + 1;
+        if (query.cost.size() < n + 2) {
+            query.cost.resize(n + 2);
+            query.parent.resize(n + 2);
+            query.toGoal.resize(n + 2);
+            query.generation.assign(n + 2, 0);
+            query.linked.assign(n + 2, 0);
+            query.current = 0;
+        }
+        if (++query.current == 0) {
+            std::fill(query.generation.begin(), query.generation.end(), 0);
+            std::fill(query.linked.begin(), query.linked.end(), 0);
+            query.current = 1;
+        }
+        query.heap.clear();
+
+        auto position = [&](size_t i) -> const Point & {
+            return i == startIndex ? start : (i == goalIndex ? goal : m_nodes[i]);
+        };
+        auto relax = [&](size_t from, size_t to, const double &cost) {
+            if (query.generation[to] != query.current || cost < query.cost[to]) {
+                query.generation[to] = query.current;
+                query.cost[to] = cost;
+                query.parent[to] = from;
+                query.heap.emplace_back(-(cost + position(to).distance(goal)), to);
+                std::push_heap(query.heap.begin(), query.heap.end());
+            }
+        };
+
+        // Links of the start, tangent to the obstacles. Those of the goal are tested once per node.
+        query.generation[startIndex] = query.current;
+        query.cost[startIndex] = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (tangent(i, start) && visible(start, m_nodes[i])) {
+                relax(startIndex, i, start.distance(m_nodes[i]));
+            }
+        }
+
+        while (!query.heap.empty()) {
+            std::pop_heap(query.heap.begin(), query.heap.end());
+            auto [priority, node] = query.heap.back();
+            query.heap.pop_back();
+            auto cost = query.cost[node];
+            if (-priority > cost + position(node).distance(goal)) {
+                continue;   // Outdated entry.
+            }
+            if (node == goalIndex) {
+                std::vector<Point> result{goal};
+                for (auto i = query.parent[goalIndex]; i != startIndex; i = query.parent[i]) {
+                    result.push_back(m_nodes[i]);
+                }
+                result.push_back(start);
+                std::reverse(result.begin(), result.end());
+                return result;
+            }
+            if (query.linked[node] != query.current) {
+                query.linked[node] = query.current;
+                query.toGoal[node] = tangent(node, goal) && visible(m_nodes[node], goal) ? m_nodes[node].distance(goal) : -1;
+            }
+            if (query.toGoal[node] >= 0) {
+                relax(node, goalIndex, cost + query.toGoal[node]);
+            }
+            for (const auto &[next, length] : m_graph[node]) {
+                relax(node, next, cost + length);
+            }
+        }
+
+        return {};
+    }
+
+    // Shortest path from start to goal, empty if there is no path.
+    auto path(const Point &start, const Point &goal) const -> std::vector<Point>
+    {
+        Query query;
+
+        return path(start, goal, query);
+    }
+};
+
+// Arc-length parametrization of a polyline or polygon outline.
+// Cumulative lengths : O(log n) point at distance and O(n + count) uniform resampling.
+class ArcLength {
+
+    std::vector<Point> m_points;
+    std::vector<double> m_lengths;
+    bool m_closed{false};
+
+    // Point at distance inside the segment starting at index.
+    auto interpolate(size_t index, const double &distance) const -> Point
+    {
+        auto segment = m_lengths[index + 1] - m_lengths[index];
+        if (segment <= 0) {
+            return m_points[index];
+        }
+        auto t = (distance - m_lengths[index]) / segment;
+        const auto &a = m_points[index];
+        const auto &b = m_points[index + 1];
+
+        return {a.X.value + (b.X.value - a.X.value) * t, a.Y.value + (b.Y.value - a.Y.value) * t};
+    }
+
+public:
+    ArcLength() = default;
+
+    explicit ArcLength(const std::vector<Point> &points, bool closed = false)
+    {
+        setup(points, closed);
+    }
+
+    // Polygon outline, a line is open.
+    explicit ArcLength(Base base)
+    {
+        auto points = base.points();
+        setup(points, points.size() > 2);
+    }
+
+    ~ArcLength() = default;
+
+    void setup(const std::vector<Point> &points, bool closed = false)
+    {
+        m_points = points;
+        m_closed = closed && points.size() > 2;
+        if (m_closed) {
+            m_points.push_back(points.front());
+        }
+
+        m_lengths.assign(m_points.size(), 0);
+        for (size_t i = 1; i < m_points.size(); ++i) {
+            m_lengths[i] = m_lengths[i - 1] + m_points[i - 1].distance(m_points[i]);
+        }
+    }
+
+    auto length() const -> double
+    {
+        return m_lengths.empty() ? 0 : m_lengths.back();
+    }
+
+    // Point at the distance from the start, clamped to the path.
+    auto at(const double &distance) const -> Point
+    {
+        if (m_points.empty()) {
+            return {};
+        }
+        if (distance <= 0 || m_points.size() == 1) {
+            return m_points.front();
+        }
+        if (distance >= length()) {
+            return m_points.back();
+        }
+
+        auto index = static_cast<size_t>(std::upper_bound(m_lengths.begin(), m_lengths.end(), distance) - m_lengths.begin()) - 1;
+
+        return interpolate(index, distance);
+    }
+
+    // Direction of the path at the distance from the start, in degrees.
+    auto angle(const double &distance) const -> double
+    {
+        if (m_points.size() < 2) {
+            return 0;
+        }
+
+        auto d = std::clamp(distance, 0.0, length());
+        auto index = static_cast<size_t>(std::upper_bound(m_lengths.begin(), m_lengths.end(), d) - m_lengths.begin());
+        index = std::clamp<size_t>(index, 1, m_points.size() - 1) - 1;
+        // Skips zero-length segments.
+        while (index + 2 < m_points.size() && m_lengths[index + 1] == m_lengths[index]) {
+            ++index;
+        }
+
+        return m_points[index].angle(m_points[index + 1]);
+    }
+
+    // Count points evenly spaced along the path, both ends included.
+    // A closed path does not repeat the first point.
+    auto resample(size_t count) const -> std::vector<Point>
+    {
+        std::vector<Point> result;
+        if (m_points.empty() || count == 0) {
+            return result;
+        }
+
+        auto intervals = m_closed ? count : count - 1;
+        auto step = intervals > 0 ? length() / intervals : 0.0;
+
+        result.reserve(count);
+        size_t index = 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto distance = std::min(i * step, length());
+            while (index + 2 < m_points.size() && m_lengths[index + 1] < distance) {
+                ++index;
+            }
+            result.push_back(m_points.size() == 1 ? m_points.front() : interpolate(index, distance));
+        }
+        if (!m_closed && count > 1) {
+            result.back() = m_points.back();
+        }
+
+        return result;
+    }
+};
+
+// Quadratic (first, second, third) or cubic (first, second, third, fourth) Bezier curve.
+class Bezier {
+
+public:
+    Point first, second, third, fourth;
+    unsigned degree{3};
+
+    Bezier() = default;
+
+    // Quadratic : start, control point and end.
+    Bezier(const Point &first, const Point &second, const Point &third)
+        : first(first), second(second), third(third), fourth(third), degree(2) {}
+
+    // Cubic : start, two control points and end.
+    Bezier(const Point &first, const Point &second, const Point &third, const Point &fourth)
+        : first(first), second(second), third(third), fourth(fourth), degree(3) {}
+
+    ~Bezier() = default;
+
+    auto start() const -> Point
+    {
+        return first;
+    }
+
+    auto end() const -> Point
+    {
+        return degree == 2 ? third : fourth;
+    }
+
+    // Point at parameter t (0 to 1).
+    auto at(const double &t) const -> Point
+    {
+        auto u = 1 - t;
+        if (degree == 2) {
+            return first * (u * u) + second * (2 * u * t) + third * (t * t);
+        }
+
+        return first * (u * u * u) + second * (3 * u * u * t) + third * (3 * u * t * t) + fourth * (t * t * t);
+    }
+
+    // Number of line segments keeping the polyline within the tolerance (Wang's formula).
+    auto segments(const double &tolerance) const -> unsigned
+    {
+        auto norm = [](const Point &a, const Point &b, const Point &c) {
+            return (a - b * 2.0 + c).distance(Origin);
+        };
+
+        double maximum = 0;
+        double factor = 0;
+        if (degree == 2) {
+            maximum = norm(first, second, third);
+            factor = 0.25;
+        }
+        else {
+            maximum = std::max(norm(first, second, third), norm(second, third, fourth));
+            factor = 0.75;
+        }
+        if (tolerance <= 0 || maximum == 0) {
+            return maximum == 0 ? 1 : 1024;
+        }
+
+        return static_cast<unsigned>(std::clamp(std::ceil(std::sqrt(factor * maximum / tolerance)), 1.0, 65536.0));
+    }
+
+    // Polyline within the tolerance, both ends included (forward differencing).
+    auto flatten(const double &tolerance) const -> std::vector<Point>
+    {
+        auto count = segments(tolerance);
+        auto h = 1.0 / count;
+
+        // Power basis : a t^3 + b t^2 + c t + d.
+        Point a, b, c;
+        if (degree == 2) {
+            b = first - second * 2.0 + third;
+            c = (second - first) * 2.0;
+        }
+        else {
+            a = fourth - first + (second - third) * 3.0;
+            b = (first - second * 2.0 + third) * 3.0;
+            c = (second - first) * 3.0;
+        }
+
+        auto f = first;
+        auto df = a * (h * h * h) + b * (h * h) + c * h;
+        auto ddf = a * (6 * h * h * h) + b * (2 * h * h);
+        auto dddf = a * (6 * h * h * h);
+
+        std::vector<Point> result;
+        result.reserve(count + 1);
+        result.push_back(f);
+        for (unsigned i = 1; i < count; ++i) {
+            f = f + df;
+            df = df + ddf;
+            ddf = ddf + dddf;
+            result.push_back(f);
+        }
+        result.push_back(end());
+
+        return result;
+    }
+};
+
+// Elliptical arc from the start angle through the sweep angle (degrees, positive : increasing angles).
+class Arc {
+
+public:
+    Point center;
+    double horizontalRadius{1}, verticalRadius{1};
+    double startAngle{0}, sweepAngle{90};
+    double rotation{0};
+
+    Arc() = default;
+
+    Arc(const Point &center, const double &horizontalRadius, const double &verticalRadius,
+        const double &startAngle, const double &sweepAngle, const double &rotation = 0)
+        : center(center), horizontalRadius(horizontalRadius), verticalRadius(verticalRadius),
+          startAngle(startAngle), sweepAngle(sweepAngle), rotation(rotation) {}
+
+    ~Arc() = default;
+
+    // Point at the angle of the ellipse.
+    auto at(const double &angle) const -> Point
+    {
+        return transform(std::cos(radians(angle)), std::sin(radians(angle)),
+                         std::cos(radians(rotation)), std::sin(radians(rotation)));
+    }
+
+    auto start() const -> Point
+    {
+        return at(startAngle);
+    }
+
+    auto end() const -> Point
+    {
+        return at(startAngle + sweepAngle);
+    }
+
+    // SVG flags.
+    auto largeArc() const -> bool
+    {
+        return std::abs(sweepAngle) > 180;
+    }
+
+    auto sweep() const -> bool
+    {
+        return sweepAngle > 0;
+    }
+
+    // Polyline within the tolerance, both ends included.
+    // Incremental rotation instead of one sin and cos per point.
+    auto flatten(const double &tolerance) const -> std::vector<Point>
+    {
+        auto radius = std::max(horizontalRadius, verticalRadius);
+        auto sweepRadians = radians(std::clamp(sweepAngle, -360.0, 360.0));
+        auto step = tolerance > 0 && tolerance < radius ? 2 * std::acos(1 - tolerance / radius) : std::numbers::pi / 2;
+        auto count = static_cast<unsigned>(std::clamp(std::ceil(std::abs(sweepRadians) / step), 1.0, 65536.0));
+
+        auto delta = sweepRadians / count;
+        auto cosDelta = std::cos(delta);
+        auto sinDelta = std::sin(delta);
+        auto c = std::cos(radians(startAngle));
+        auto s = std::sin(radians(startAngle));
+        auto cr = std::cos(radians(rotation));
+        auto sr = std::sin(radians(rotation));
+
+        std::vector<Point> result;
+        result.reserve(count + 1);
+        for (unsigned i = 0; i <= count; ++i) {
+            result.push_back(transform(c, s, cr, sr));
+            auto next = c * cosDelta - s * sinDelta;
+            s = s * cosDelta + c * sinDelta;
+            c = next;
+        }
+        result.back() = end();
+
+        return result;
+    }
+
+private:
+    // Ellipse point (cos, sin) rotated by (cr, sr) around the center.
+    auto transform(const double &c, const double &s, const double &cr, const double &sr) const -> Point
+    {
+        auto x = horizontalRadius * c;
+        auto y = verticalRadius * s;
+
+        return {center.X.value + x * cr - y * sr, center.Y.value + x * sr + y * cr};
+    }
+};
+
+// Offset outlines of polygons and polylines, O(n) plus the round join points.
+// Large inward offsets of concave polygons are not cleaned and may self-intersect.
+class Offset {
+
+public:
+    enum join {
+        MITER, ROUND, BEVEL
+    };
+
+private:
+    // Unit normal on the left side of (a,b).
+    static auto normal(const Point &a, const Point &b) -> Point
+    {
+        auto length = a.distance(b);
+
+        return {-(b.Y.value - a.Y.value) / length, (b.X.value - a.X.value) / length};
+    }
+
+    static auto cross(const Point &a, const Point &b) -> double
+    {
+        return a.X.value * b.Y.value - a.Y.value * b.X.value;
+    }
+
+    static auto dot(const Point &a, const Point &b) -> double
+    {
+        return a.X.value * b.X.value + a.Y.value * b.Y.value;
+    }
+
+    // Arc around the vertex from the offset point a to b, both excluded.
+    static void arc(std::vector<Point> &result, const Point &vertex, const Point &a, const Point &b,
+                    const double &distance, const double &tolerance)
+    {
+        auto radius = std::abs(distance);
+        auto sweep = (distance > 0 ? -1 : 1) * std::acos(std::clamp(dot(a - vertex, b - vertex) / (radius * radius), -1.0, 1.0));
+        auto step = tolerance > 0 && tolerance < radius ? 2 * std::acos(1 - tolerance / radius) : std::numbers::pi / 2;
+        auto count = static_cast<unsigned>(std::ceil(std::abs(sweep) / step));
+
+        auto delta = sweep / std::max(count, 1U);
+        auto c = std::cos(delta);
+        auto s = std::sin(delta);
+        auto x = a.X.value - vertex.X.value;
+        auto y = a.Y.value - vertex.Y.value;
+        for (unsigned i = 1; i < count; ++i) {
+            auto next = x * c - y * s;
+            y = y * c + x * s;
+            x = next;
+            result.emplace_back(vertex.X.value + x, vertex.Y.value + y);
+        }
+    }
+
+public:
+    // Offset of the path on its left side (distance < 0 : right side).
+    // Closed : the last point joins the first.
+    static auto path(const std::vector<Point> &points, const double &distance, bool closed, join type = MITER,
+                     const double &miterLimit = 4, const double &tolerance = 0.25) -> std::vector<Point>
+    {
+        auto vertices = Point::weld(points, 0, closed);
+        std::vector<Point> result;
+        if (vertices.size() < 2 || distance == 0) {
+            return distance == 0 ? vertices : result;
+        }
+
+        const auto n = vertices.size();
+        result.reserve(n * 2);
+        if (!closed) {
+            result.push_back(vertices[0] + normal(vertices[0], vertices[1]) * distance);
+        }
+
+        auto begin = closed ? 0 : 1;
+        auto end = closed ? n : n - 1;
+        for (size_t k = begin; k < end; ++k) {
+            const auto &previous = vertices[(k + n - 1) % n];
+            const auto &vertex = vertices[k];
+            const auto &next = vertices[(k + 1) % n];
+            auto nIn = normal(previous, vertex);
+            auto nOut = normal(vertex, next);
+            auto a = vertex + nIn * distance;
+            auto b = vertex + nOut * distance;
+            auto turn = cross(vertex - previous, next - vertex);
+            auto cosine = dot(nIn, nOut);
+
+            if (cosine > 1 - 1e-12) {
+                // Straight.
+                result.push_back(a);
+            }
+            else if (turn * distance > 0) {
+                // Inner side : intersection of the offset edges.
+                auto pa = previous + nIn * distance;
+                auto pb = next + nOut * distance;
+                auto denominator = cross(a - pa, pb - b);
+                auto t = denominator != 0 ? cross(b - pa, pb - b) / denominator : -1;
+                auto u = denominator != 0 ? cross(b - pa, a - pa) / denominator : -1;
+                if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
+                    result.push_back(pa + (a - pa) * t);
+                }
+                else {
+                    result.push_back(a);
+                    result.push_back(vertex);
+                    result.push_back(b);
+                }
+            }
+            else if (type == MITER && cosine > -1 + 1e-12 && std::sqrt(2 / (1 + cosine)) <= miterLimit) {
+                result.push_back(vertex + (nIn + nOut) * (distance / (1 + cosine)));
+            }
+            else {
+                result.push_back(a);
+                if (type == ROUND) {
+                    arc(result, vertex, a, b, distance, tolerance);
+                }
+                result.push_back(b);
+            }
+        }
+
+        if (!closed) {
+            result.push_back(vertices[n - 1] + normal(vertices[n - 2], vertices[n - 1]) * distance);
+        }
+
+        return result;
+    }
+
+    // Grows (distance > 0) or shrinks (distance < 0) the polygon.
+    static auto polygon(Base base, const double &distance, join type = MITER,
+                        const double &miterLimit = 4, const double &tolerance = 0.25) -> Base
+    {
+        auto points = base.points();
+        double area = 0;
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            area += points[j].X.value * points[i].Y.value - points[i].X.value * points[j].Y.value;
+        }
+
+        // Counterclockwise : the left side is the inside.
+        Base result;
+        if (points.size() > 2) {
+            result.setup(path(points, area > 0 ? -distance : distance, true, type, miterLimit, tolerance));
+        }
+
+        return result;
+    }
+
+    // Outline of the stroke of an open path, caps : round for ROUND joins, otherwise butt.
+    static auto stroke(const std::vector<Point> &points, const double &width, join type = MITER,
+                       const double &miterLimit = 4, const double &tolerance = 0.25) -> Base
+    {
+        // Forward and backward : the ends become U-turns.
+        auto there = Point::weld(points, 0);
+        auto loop = there;
+        for (auto i = static_cast<long long>(there.size()) - 2; i > 0; --i) {
+            loop.push_back(there[i]);
+        }
+
+        Base result;
+        if (there.size() > 1) {
+            result.setup(path(loop, width / 2, true, type, miterLimit, tolerance));
+        }
+
+        return result;
+    }
+
+    // Outlines of the stroke of a polygon : outer and inner.
+    // A point is on the stroke if the first contains it and the second does not.
+    static auto stroke(Base base, const double &width, join type = MITER,
+                       const double &miterLimit = 4, const double &tolerance = 0.25) -> std::vector<Base>
+    {
+        auto points = base.points();
+        if (points.size() < 3) {
+            return {stroke(points, width, type, miterLimit, tolerance)};
+        }
+
+        return {polygon(base, width / 2, type, miterLimit, tolerance), polygon(base, -width / 2, type, miterLimit, tolerance)};
+    }
+};
+
+// Boolean operations between polygons.
+// The edges are split at their crossings and contacts (shared vertices, vertices on edges,
+// overlapping edges), then selected by their position relative to the other polygon.
+// The results are returned as Base, ready for Sketch::join :
+// outlines counterclockwise, holes clockwise (see Sketch::svgRegion).
+class Clipping {
+
+public:
+    enum operation {
+        INTERSECTION, UNION, DIFFERENCE, XOR
+    };
+
+private:
+    using Contour = std::vector<Point>;
+
+    // {min X, min Y, max X, max Y}.
+    using Box = std::array<double, 4>;
+
+    struct Edge {
+        int from{0}, to{0};
+        int owner{0};   // 0 : subject, 1 : clip.
+    };
+
+    // Vertices closer than the tolerance are merged, found with a hash grid.
+    class Vertices {
+        std::vector<Point> m_points;
+        std::unordered_map<long long, std::vector<int> > m_grid;
+        double m_tolerance;
+
+        static auto key(long long x, long long y) -> long long
+        {
+            return x * 2654435761LL + y;
+        }
+
+    public:
+        explicit Vertices(const double &tolerance) : m_tolerance(tolerance) {}
+
+        auto add(const double &x, const double &y) -> int
+        {
+            auto cx = static_cast<long long>(std::floor(x / m_tolerance));
+            auto cy = static_cast<long long>(std::floor(y / m_tolerance));
+            for (long long dx = -1; dx <= 1; ++dx) {
+                for (long long dy = -1; dy <= 1; ++dy) {
+                    auto cell = m_grid.find(key(cx + dx, cy + dy));
+                    if (cell == m_grid.end()) {
+                        continue;
+                    }
+                    for (auto id : cell->second) {
+                        if (std::abs(m_points[id].X.value - x) <= m_tolerance &&
+                            std::abs(m_points[id].Y.value - y) <= m_tolerance) {
+                            return id;
+                        }
+                    }
+                }
+            }
+            m_points.emplace_back(x, y);
+            m_grid[key(cx, cy)].push_back(static_cast<int>(m_points.size() - 1));
+
+            return static_cast<int>(m_points.size() - 1);
+        }
+
+        auto operator[](int id) const -> const Point &
+        {
+            return m_points[id];
+        }
+
+        auto size() const -> size_t
+        {
+            return m_points.size();
+        }
+    };
+
+    // Signed area (Shoelace formula).
+    static auto signedArea(const Contour &polygon) -> double
+    {
+        double result = 0;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            result += polygon[j].X.value * polygon[i].Y.value - polygon[i].X.value * polygon[j].Y.value;
+        }
+
+        return result / 2;
+    }
+
+    static auto bounds(const Contour &polygon) -> Box
+    {
+        Box result{
+            std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()
+        };
+        for (const auto &point : polygon) {
+            result[0] = std::min(result[0], point.X.value);
+            result[1] = std::min(result[1], point.Y.value);
+            result[2] = std::max(result[2], point.X.value);
+            result[3] = std::max(result[3], point.Y.value);
+        }
+
+        return result;
+    }
+
+    // Counterclockwise outline.
+    static auto outline(Contour polygon) -> Contour
+    {
+        if (signedArea(polygon) < 0) {
+            std::reverse(polygon.begin(), polygon.end());
+        }
+
+        return polygon;
+    }
+
+    // Pairs of boxes from the two lists that overlap (sort and sweep on X).
+    template<typename Visit>
+    static void sweep(const std::vector<Box> &boxes, const std::vector<int> &owners, const double &tolerance, Visit visit)
+    {
+        std::vector<size_t> order(boxes.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&boxes](size_t a, size_t b) {
+            return boxes[a][0] < boxes[b][0];
+        });
+
+        std::vector<size_t> active;
+        for (auto i : order) {
+            const auto &box = boxes[i];
+            active.erase(std::remove_if(active.begin(), active.end(), [&](size_t j) {
+                return boxes[j][2] < box[0] - tolerance;
+            }), active.end());
+            for (auto j : active) {
+                if (owners[i] != owners[j] && boxes[j][1] <= box[3] + tolerance && box[1] <= boxes[j][3] + tolerance) {
+                    visit(i, j);
+                }
+            }
+            active.push_back(i);
+        }
+    }
+
+    // Boolean operation between two regions, interior on the left of the edges
+    // (outlines counterclockwise, holes clockwise). Returns the contours in the same convention.
+    static auto execute(const std::vector<Contour> &subject, const std::vector<Contour> &clip, operation op)
+        -> std::vector<Contour>
+    {
+        double scale = 1;
+        for (const auto *region : {&subject, &clip}) {
+            for (const auto &contour : *region) {
+                for (const auto &point : contour) {
+                    scale = std::max({scale, std::abs(point.X.value), std::abs(point.Y.value)});
+                }
+            }
+        }
+        const double tolerance = scale * 1e-9;
+        Vertices vertices(tolerance);
+
+        // Edges of both regions on the merged vertices.
+        std::vector<Edge> edges;
+        auto add = [&](const std::vector<Contour> &region, int owner) {
+            for (const auto &contour : region) {
+                if (contour.size() < 3) {
+                    continue;
+                }
+                std::vector<int> ids;
+                for (const auto &point : contour) {
+                    ids.push_back(vertices.add(point.X.value, point.Y.value));
+                }
+                for (size_t i = 0; i < ids.size(); ++i) {
+                    auto to = ids[(i + 1) % ids.size()];
+                    if (ids[i] != to) {
+                        edges.push_back({ids[i], to, owner});
+                    }
+                }
+            }
+        };
+        add(subject, 0);
+        add(clip, 1);
+
+        // Phase 1 : split points of the edges, sorted along each edge.
+        // Vertices of the other region on the edge (contacts and overlaps), then the crossings.
+        std::vector<std::vector<std::pair<double, int> > > splits(edges.size());
+        auto touch = [&](size_t edge, int vertex) -> bool {
+            const auto &a = vertices[edges[edge].from];
+            const auto &b = vertices[edges[edge].to];
+            const auto &v = vertices[vertex];
+            auto dx = b.X.value - a.X.value, dy = b.Y.value - a.Y.value;
+            auto rx = v.X.value - a.X.value, ry = v.Y.value - a.Y.value;
+            auto length = std::sqrt(dx * dx + dy * dy);
+            auto t = (rx * dx + ry * dy) / (length * length);
+            if (std::abs(dx * ry - dy * rx) / length > tolerance || t * length <= tolerance || (1 - t) * length <= tolerance) {
+                return false;
+            }
+            splits[edge].emplace_back(t, vertex);
+            return true;
+        };
+        auto contact = [&](size_t e, size_t f) {
+            const auto &p = edges[e];
+            const auto &q = edges[f];
+            if (p.from == q.from || p.from == q.to || p.to == q.from || p.to == q.to) {
+                // Shared vertex : a collinear overlap is found from the far vertices.
+                touch(e, p.from == q.from || p.to == q.from ? q.to : q.from);
+                touch(f, q.from == p.from || q.to == p.from ? p.to : p.from);
+                return;
+            }
+            bool touched = touch(e, q.from);
+            touched = touch(e, q.to) || touched;
+            touched = touch(f, p.from) || touched;
+            touched = touch(f, p.to) || touched;
+            if (touched) {
+                return;
+            }
+
+            const auto &p0 = vertices[p.from];
+            const auto &p1 = vertices[p.to];
+            const auto &q0 = vertices[q.from];
+            const auto &q1 = vertices[q.to];
+            auto rx = p1.X.value - p0.X.value, ry = p1.Y.value - p0.Y.value;
+            auto sx = q1.X.value - q0.X.value, sy = q1.Y.value - q0.Y.value;
+            auto qx = q0.X.value - p0.X.value, qy = q0.Y.value - p0.Y.value;
+            auto d = rx * sy - ry * sx;
+            if (d == 0) {
+                return;
+            }
+            auto a = (qx * sy - qy * sx) / d;
+            auto b = (qx * ry - qy * rx) / d;
+            auto lengthP = std::sqrt(rx * rx + ry * ry);
+            auto lengthQ = std::sqrt(sx * sx + sy * sy);
+            if (a * lengthP <= tolerance || (1 - a) * lengthP <= tolerance ||
+                b * lengthQ <= tolerance || (1 - b) * lengthQ <= tolerance) {
+                return;
+            }
+            auto vertex = vertices.add(p0.X.value + a * rx, p0.Y.value + a * ry);
+            splits[e].emplace_back(a, vertex);
+            splits[f].emplace_back(b, vertex);
+        };
+
+        std::vector<Box> boxes;
+        std::vector<int> owners;
+        boxes.reserve(edges.size());
+        for (const auto &edge : edges) {
+            const auto &a = vertices[edge.from];
+            const auto &b = vertices[edge.to];
+            boxes.push_back({std::min(a.X.value, b.X.value), std::min(a.Y.value, b.Y.value),
+                             std::max(a.X.value, b.X.value), std::max(a.Y.value, b.Y.value)});
+            owners.push_back(edge.owner);
+        }
+        sweep(boxes, owners, tolerance, contact);
+
+        std::vector<Edge> pieces;
+        for (size_t i = 0; i < edges.size(); ++i) {
+            std::sort(splits[i].begin(), splits[i].end());
+            auto previous = edges[i].from;
+            for (const auto &split : splits[i]) {
+                if (split.second != previous && split.second != edges[i].to) {
+                    pieces.push_back({previous, split.second, edges[i].owner});
+                    previous = split.second;
+                }
+            }
+            pieces.push_back({previous, edges[i].to, edges[i].owner});
+        }
+
+        // Phase 2 : position of the pieces. Pieces with the same vertices in both regions are shared boundaries.
+        auto count = static_cast<long long>(vertices.size());
+        auto key = [count](const Edge &edge) {
+            return std::min(edge.from, edge.to) * count + std::max(edge.from, edge.to);
+        };
+        std::unordered_map<long long, size_t> shared;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            if (pieces[i].owner == 1) {
+                shared.emplace(key(pieces[i]), i);
+            }
+        }
+
+        // Point in region (even-odd rule), the pieces of each region in horizontal bands.
+        struct Bands {
+            double minimum{0}, height{1};
+            std::vector<std::vector<size_t> > items;
+        };
+        std::array<Bands, 2> bands;
+        for (int owner = 0; owner < 2; ++owner) {
+            auto &band = bands[owner];
+            double minimum = std::numeric_limits<double>::max(), maximum = std::numeric_limits<double>::lowest();
+            size_t number = 0;
+            for (const auto &piece : pieces) {
+                if (piece.owner == owner) {
+                    minimum = std::min({minimum, vertices[piece.from].Y.value, vertices[piece.to].Y.value});
+                    maximum = std::max({maximum, vertices[piece.from].Y.value, vertices[piece.to].Y.value});
+                    number++;
+                }
+            }
+            if (number == 0) {
+                continue;
+            }
+            band.items.resize(maximum > minimum ? number : 1);
+            band.minimum = minimum;
+            band.height = maximum > minimum ? (maximum - minimum) / static_cast<double>(band.items.size()) : 1;
+            for (size_t i = 0; i < pieces.size(); ++i) {
+                if (pieces[i].owner != owner) {
+                    continue;
+                }
+                auto y0 = vertices[pieces[i].from].Y.value, y1 = vertices[pieces[i].to].Y.value;
+                auto first = std::min(band.items.size() - 1, static_cast<size_t>((std::min(y0, y1) - minimum) / band.height));
+                auto last = std::min(band.items.size() - 1, static_cast<size_t>((std::max(y0, y1) - minimum) / band.height));
+                for (auto j = first; j <= last; ++j) {
+                    band.items[j].push_back(i);
+                }
+            }
+        }
+        auto inside = [&](int owner, const double &x, const double &y) {
+            const auto &band = bands[owner];
+            if (band.items.empty() || y < band.minimum) {
+                return false;
+            }
+            auto index = static_cast<size_t>((y - band.minimum) / band.height);
+            if (index >= band.items.size()) {
+                return false;
+            }
+            bool result = false;
+            for (auto i : band.items[index]) {
+                const auto &a = vertices[pieces[i].from];
+                const auto &b = vertices[pieces[i].to];
+                if ((a.Y.value > y) != (b.Y.value > y) &&
+                    x < (b.X.value - a.X.value) * (y - a.Y.value) / (b.Y.value - a.Y.value) + a.X.value) {
+                    result = !result;
+                }
+            }
+            return result;
+        };
+
+        // Phase 3 : selection.
+        std::vector<Edge> selected;
+        std::vector<bool> paired(pieces.size(), false);
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            const auto &piece = pieces[i];
+            if (piece.owner == 0) {
+                auto other = shared.find(key(piece));
+                if (other != shared.end()) {
+                    paired[other->second] = true;
+                    // Same direction : interiors on the same side.
+                    bool same = pieces[other->second].from == piece.from;
+                    if (same ? op == UNION || op == INTERSECTION : op == DIFFERENCE) {
+                        selected.push_back(piece);
+                    }
+                    continue;
+                }
+            }
+            else if (paired[i]) {
+                continue;
+            }
+
+            const auto &a = vertices[piece.from];
+            const auto &b = vertices[piece.to];
+            bool in = inside(1 - piece.owner, (a.X.value + b.X.value) / 2, (a.Y.value + b.Y.value) / 2);
+            Edge reversed{piece.to, piece.from, piece.owner};
+            switch (op) {
+            case UNION:
+                if (!in) {
+                    selected.push_back(piece);
+                }
+                break;
+            case INTERSECTION:
+                if (in) {
+                    selected.push_back(piece);
+                }
+                break;
+            case DIFFERENCE:
+                if (piece.owner == 0 && !in) {
+                    selected.push_back(piece);
+                }
+                if (piece.owner == 1 && in) {
+                    selected.push_back(reversed);
+                }
+                break;
+            default:    // XOR
+                selected.push_back(in ? reversed : piece);
+                break;
+            }
+        }
+
+        // Phase 4 : contours, turning as far left as possible where contours touch.
+        std::vector<std::vector<size_t> > outgoing(vertices.size());
+        for (size_t i = 0; i < selected.size(); ++i) {
+            outgoing[selected[i].from].push_back(i);
+        }
+        std::vector<bool> used(selected.size(), false);
+        std::vector<Contour> result;
+        for (size_t i = 0; i < selected.size(); ++i) {
+            if (used[i]) {
+                continue;
+            }
+            Contour contour;
+            auto current = i;
+            bool closed = false;
+            while (true) {
+                used[current] = true;
+                contour.push_back(vertices[selected[current].from]);
+                auto vertex = selected[current].to;
+                if (vertex == selected[i].from) {
+                    closed = true;
+                    break;
+                }
+                const auto &a = vertices[selected[current].from];
+                const auto &b = vertices[vertex];
+                auto dx = b.X.value - a.X.value, dy = b.Y.value - a.Y.value;
+                int next = -1;
+                double best = 0;
+                for (auto candidate : outgoing[vertex]) {
+                    if (used[candidate]) {
+                        continue;
+                    }
+                    const auto &c = vertices[selected[candidate].to];
+                    auto ex = c.X.value - b.X.value, ey = c.Y.value - b.Y.value;
+                    auto angle = std::atan2(dx * ey - dy * ex, dx * ex + dy * ey);
+                    if (next < 0 || angle > best) {
+                        next = static_cast<int>(candidate);
+                        best = angle;
+                    }
+                }
+                if (next < 0) {
+                    break;
+                }
+                current = static_cast<size_t>(next);
+            }
+            if (!closed) {
+                continue;
+            }
+
+            // Removes the vertices between collinear edges.
+            bool changed = true;
+            while (changed && contour.size() > 2) {
+                changed = false;
+                Contour simplified;
+                for (size_t j = 0; j < contour.size(); ++j) {
+                    const auto &a = simplified.empty() ? contour[(j + contour.size() - 1) % contour.size()] : simplified.back();
+                    const auto &b = contour[j];
+                    const auto &c = contour[(j + 1) % contour.size()];
+                    auto ux = b.X.value - a.X.value, uy = b.Y.value - a.Y.value;
+                    auto vx = c.X.value - b.X.value, vy = c.Y.value - b.Y.value;
+                    auto length = std::sqrt(ux * ux + uy * uy) + std::sqrt(vx * vx + vy * vy);
+                    if (std::abs(ux * vy - uy * vx) <= tolerance * length) {
+                        changed = true;
+                        continue;
+                    }
+                    simplified.push_back(b);
+                }
+                contour = simplified;
+            }
+            if (contour.size() > 2 && std::abs(signedArea(contour)) > tolerance * scale) {
+                result.push_back(contour);
+            }
+        }
+
+        return result;
+    }
+
+    static auto contours(const std::vector<Point> &subject, const std::vector<Point> &clip, operation op)
+        -> std::vector<Contour>
+    {
+        if (subject.size() < 3) {
+            return op == UNION || op == XOR ? std::vector<Contour> {outline(clip)} : std::vector<Contour> {};
+        }
+        if (clip.size() < 3) {
+            return op == INTERSECTION ? std::vector<Contour> {} : std::vector<Contour> {outline(subject)};
+        }
+
+        return execute({outline(subject)}, {outline(clip)}, op);
+    }
+
+    // Union of two regions. The contours away from the other region are kept as they are.
+    static auto merge(std::vector<Contour> group, const std::vector<Contour> &other) -> std::vector<Contour>
+    {
+        std::vector<Box> boxes;
+        std::vector<int> owners;
+        for (const auto &contour : group) {
+            boxes.push_back(bounds(contour));
+            owners.push_back(0);
+        }
+        for (const auto &contour : other) {
+            boxes.push_back(bounds(contour));
+            owners.push_back(1);
+        }
+        std::vector<bool> involved(boxes.size(), false);
+        sweep(boxes, owners, 0, [&involved](size_t i, size_t j) {
+            involved[i] = involved[j] = true;
+        });
+
+        std::vector<Contour> result, subject, clip;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const auto &contour = i < group.size() ? group[i] : other[i - group.size()];
+            if (!involved[i]) {
+                result.push_back(contour);
+            }
+            else {
+                (i < group.size() ? subject : clip).push_back(contour);
+            }
+        }
+        if (!subject.empty()) {
+            auto united = execute(subject, clip, UNION);
+            result.insert(result.end(), united.begin(), united.end());
+        }
+
+        return result;
+    }
+
+    // Divide and conquer, the first levels in parallel.
+    static auto cascade(const std::vector<Contour> &polygons, size_t begin, size_t end, int depth)
+        -> std::vector<Contour>
+    {
+        if (end - begin == 1) {
+            return {polygons[begin]};
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        if (depth > 0) {
+            auto left = std::async(std::launch::async, cascade, std::cref(polygons), begin, middle, depth - 1);
+            auto right = cascade(polygons, middle, end, depth - 1);
+            return merge(left.get(), right);
+        }
+
+        return merge(cascade(polygons, begin, middle, 0), cascade(polygons, middle, end, 0));
+    }
+
+    static auto toBase(const std::vector<Contour> &contours) -> std::vector<Base>
+    {
+        std::vector<Base> result;
+        for (const auto &contour : contours) {
+            Base base;
+            base.setup(contour);
+            result.push_back(base);
+        }
+
+        return result;
+    }
+
+public:
+    // Boolean operation between two polygons.
+    static auto clip(Base subject, Base clip, operation op) -> std::vector<Base>
+    {
+        return toBase(contours(subject.points(), clip.points(), op));
+    }
+
+    static auto intersection(const Base &subject, const Base &clip) -> std::vector<Base>
+    {
+        return Clipping::clip(subject, clip, INTERSECTION);
+    }
+
+    static auto unite(const Base &subject, const Base &clip) -> std::vector<Base>
+    {
+        return Clipping::clip(subject, clip, UNION);
+    }
+
+    // A clip inside the subject is returned as a clockwise hole.
+    static auto difference(const Base &subject, const Base &clip) -> std::vector<Base>
+    {
+        return Clipping::clip(subject, clip, DIFFERENCE);
+    }
+
+    static auto exclusive(const Base &subject, const Base &clip) -> std::vector<Base>
+    {
+        return Clipping::clip(subject, clip, XOR);
+    }
+
+    // Returns true for a hole (clockwise contour of a result).
+    static auto hole(Base polygon) -> bool
+    {
+        return signedArea(polygon.points()) < 0;
+    }
+
+    // Cascaded union : merges all polygons, returning the outlines and the holes.
+    // Threads : number of threads, 0 uses the hardware concurrency.
+    static auto unite(std::vector<Base> polygons, unsigned threads = 0) -> std::vector<Base>
+    {
+        std::vector<Contour> contours;
+        for (auto &polygon : polygons) {
+            auto points = polygon.points();
+            if (points.size() > 2) {
+                contours.push_back(outline(points));
+            }
+        }
+        if (contours.empty()) {
+            return {};
+        }
+
+        threads = threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+        int depth = 0;
+        while ((1U << depth) < threads) {
+            depth++;
+        }
+
+        return toBase(cascade(contours, 0, contours.size(), depth));
+    }
+};
+
 }; // namespace Math
 
 }; // namespace stbox
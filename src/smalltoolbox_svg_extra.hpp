@@ -15,6 +15,23 @@ class Sketch : public stbox::Image::SVG, public stbox::Image::Color {
 
 public:
 
+    // Level of detail setup.
+    // scale     : output size of one geometry unit (zoom),
+    // minimum   : shapes smaller than this output size are removed,
+    // primitive : shapes smaller than this output size become rectangles,
+    // tolerance : maximum output deviation when removing vertices.
+    struct LevelOfDetail {
+        double scale{1.0};
+        double minimum{0.5};
+        double primitive{2.0};
+        double tolerance{0.25};
+
+        LevelOfDetail() = default;
+        explicit LevelOfDetail(const double &scale) : scale(scale) {}
+        LevelOfDetail(const double &scale, const double &minimum, const double &primitive, const double &tolerance)
+            : scale(scale), minimum(minimum), primitive(primitive), tolerance(tolerance) {}
+    };
+
     // Return basic SVG::Shape with Polygon base.
     static auto normalShape(stbox::Math::Base base, const std::string &label) -> stbox::Image::SVG::NormalShape
     {
@@ -94,6 +111,17 @@ public:
         return stbox::Image::SVG::polygon(normalShape(base, label));
     }
 
+    // Return SVG::region with the result of a boolean operation (Math::Clipping), holes cut out.
+    static auto svgRegion(std::vector<stbox::Math::Base> bases, const std::string &label) -> std::string
+    {
+        std::vector<std::vector<std::array<double, 2> > > contours;
+        for (auto &base : bases) {
+            contours.push_back(base.pointsXY());
+        }
+
+        return stbox::Image::SVG::region(normalShape(stbox::Math::Base(), label), contours);
+    }
+
     // Return SVG::polygon with Polygon base.
     static auto svgPolygon(stbox::Math::Base base, const std::string &label, const stbox::Image::Color::RGBA &fill,
                            const stbox::Image::Color::RGBA &stroke) -> std::string
@@ -137,6 +165,44 @@ public:
                                              base.pointsXY()));
     }
 
+    // Return SVG::polygon with Polygon base snapped to the grid.
+    // Integer formatting : the grid nodes are written as exact decimal multiples of the step.
+    static auto svgPolygon(const stbox::Math::Grid &grid, stbox::Math::Base base, const std::string &label,
+                           const stbox::Image::Color::RGBA &fill,
+                           const stbox::Image::Color::RGBA &stroke) -> std::string
+    {
+        auto cells = grid.snap(base);
+
+        // Step : integer factor and number of decimals, from its shortest representation.
+        std::array<char, 32> buffer{};
+        std::string step(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), grid.step).ptr);
+        auto point = step.find('.');
+        auto decimals = point == std::string::npos ? 0 : static_cast<int>(step.size() - point - 1);
+        if (point != std::string::npos) {
+            step.erase(point, 1);
+        }
+        long long factor = 0;
+        auto [end, error] = std::from_chars(step.data(), step.data() + step.size(), factor);
+        if (error != std::errc() || end != step.data() + step.size() || decimals > 9) {
+            // Exponent notation.
+            base.setup(grid.points(cells));
+            return svgPolygon(base, label, fill, stroke);
+        }
+
+        for (auto &cell : cells) {
+            cell[0] *= factor;
+            cell[1] *= factor;
+        }
+        stbox::Image::SVG::IntegerShape shape(label,
+                                              RGB2hex(fill.R, fill.G, fill.B),
+                                              RGB2hex(stroke.R, stroke.G, stroke.B),
+                                              1.0, // strokeWidth
+                                              cells);
+        shape.decimals = decimals;
+
+        return stbox::Image::SVG::polygon(shape);
+    }
+
     // Return SVG::circle with Ellipse base.
     static auto svgCircle(const stbox::Math::Ellipse &ellipse, const std::string &label) -> std::string
     {
@@ -194,6 +260,77 @@ public:
                                             ellipse.verticalRadius));
     }
 
+    // Return SVG::bezier with a Bezier curve.
+    static auto svgBezier(const stbox::Math::Bezier &curve, const std::string &label) -> std::string
+    {
+        stbox::Image::SVG::NormalShape shape;
+        shape.name = label;
+        shape.fill = "none";
+        for (const auto &point : {curve.first, curve.second, curve.third, curve.fourth}) {
+            if (shape.points.size() <= curve.degree) {
+                shape.points.push_back({point.X.value, point.Y.value});
+            }
+        }
+
+        return stbox::Image::SVG::bezier(shape, curve.degree);
+    }
+
+    // Return SVG::arc with an elliptical arc.
+    // A full turn is written as two half arcs.
+    static auto svgArc(const stbox::Math::Arc &arc, const std::string &label,
+                       const stbox::Image::Color::RGBA &fill,
+                       const stbox::Image::Color::RGBA &stroke) -> std::string
+    {
+        std::vector<std::array<double, 2> > points;
+        for (const auto &point : {arc.start(), arc.at(arc.startAngle + arc.sweepAngle / 2), arc.end()}) {
+            points.push_back({point.X.value, point.Y.value});
+        }
+        if (std::abs(arc.sweepAngle) < 360) {
+            points.erase(points.begin() + 1);
+        }
+
+        return stbox::Image::SVG::arc(stbox::Image::SVG::ArcShape(label,
+                                         RGB2hex(fill.R, fill.G, fill.B),
+                                         RGB2hex(stroke.R, stroke.G, stroke.B),
+                                         1.0,    // strokeWidth
+                                         points,
+                                         arc.horizontalRadius,
+                                         arc.verticalRadius,
+                                         arc.rotation,
+                                         points.size() == 2 && arc.largeArc(),
+                                         arc.sweep()));
+    }
+
+    // Return SVG::arc with an elliptical arc.
+    static auto svgArc(const stbox::Math::Arc &arc, const std::string &label) -> std::string
+    {
+        return svgArc(arc, label, RGBA{255, 255, 255, 255}, RGBA{0, 0, 0, 255});
+    }
+
+    // Return SVG group with one rectangle per sample of the distance field.
+    // Range : distance mapped to black (-range) and white (+range).
+    static auto svgDistanceField(const stbox::Math::DistanceField &field, const std::string &label,
+                                 const double &range) -> std::string
+    {
+        std::string elements{};
+        auto size = number(field.step);
+        for (size_t row = 0; row < field.rows; ++row) {
+            for (size_t column = 0; column < field.columns; ++column) {
+                auto value = range > 0 ? std::clamp((field.at(column, row) + range) / (2 * range), 0.0, 1.0) : 0.0;
+                auto gray = static_cast<int>(value * 255);
+                auto position = field.position(column, row) - field.step / 2;
+                elements += "<rect x=\"";
+                number(elements, position.X.value);
+                elements += "\" y=\"";
+                number(elements, position.Y.value);
+                elements += "\" width=\"" + size + "\" height=\"" + size + "\" " +
+                            "style=\"fill:" + RGB2hex(gray, gray, gray) + ";stroke:none\" />\n";
+            }
+        }
+
+        return group(label, elements);
+    }
+
     // Returns SVG Elements.
     static auto join(const std::vector<stbox::Math::Base> &bases, const std::string &label = "") -> std::string
     {
@@ -205,6 +342,138 @@ public:
         return strShape;
     }
 
+    // Returns SVG Elements, serialized in parallel (threads 0 : hardware concurrency), same output as join.
+    static auto joinParallel(const std::vector<stbox::Math::Base> &bases, const std::string &label = "",
+                             unsigned threads = 0) -> std::string
+    {
+        return elements(bases.size(), [&](size_t i, std::string &text) {
+            text += Sketch::svgPolygon(bases[i], label);
+        }, threads);
+    }
+
+    // Returns true if the bounding box of the shape crosses the document (0,0)(width,height).
+    static auto visible(stbox::Math::Base &base, const double &width, const double &height) -> bool
+    {
+        if (base.points().empty()) {
+            return false;
+        }
+
+        auto [min, max] = base.boundingBox();
+
+        return max.X.value >= 0 && max.Y.value >= 0 && min.X.value <= width && min.Y.value <= height;
+    }
+
+    // Returns true if the ellipse crosses the document (0,0)(width,height).
+    static auto visible(const stbox::Math::Ellipse &ellipse, const double &width, const double &height) -> bool
+    {
+        return ellipse.center.X.value + ellipse.horizontalRadius >= 0 &&
+               ellipse.center.Y.value + ellipse.verticalRadius >= 0 &&
+               ellipse.center.X.value - ellipse.horizontalRadius <= width &&
+               ellipse.center.Y.value - ellipse.verticalRadius <= height;
+    }
+
+    // Viewport culling : removes the shapes outside the document (0,0)(width,height).
+    // Clip : cuts the polygons partially visible.
+    static auto cull(std::vector<stbox::Math::Base> bases, const double &width, const double &height,
+                     bool clip = false) -> std::vector<stbox::Math::Base>
+    {
+        stbox::Math::Rectangle viewport(stbox::Math::Origin, width, height);
+
+        std::vector<stbox::Math::Base> result;
+        for (auto &item : bases) {
+            if (!visible(item, width, height)) {
+                continue;
+            }
+            auto [min, max] = item.boundingBox();
+            bool inside = min.X.value >= 0 && min.Y.value >= 0 && max.X.value <= width && max.Y.value <= height;
+            if (!clip || inside || item.points().size() < 3) {
+                result.push_back(item);
+                continue;
+            }
+            for (const auto &polygon : stbox::Math::Clipping::intersection(item, viewport)) {
+                result.push_back(polygon);
+            }
+        }
+
+        return result;
+    }
+
+    // Decimation by output size.
+    // Removes the tiny shapes, collapses the small ones to their bounding box
+    // and simplifies the others.
+    static auto decimate(std::vector<stbox::Math::Base> bases, const LevelOfDetail &lod) -> std::vector<stbox::Math::Base>
+    {
+        if (lod.scale <= 0) {
+            return {};
+        }
+
+        std::vector<stbox::Math::Base> result;
+        for (auto &item : bases) {
+            auto points = item.points();
+            if (points.empty()) {
+                continue;
+            }
+            auto [min, max] = item.boundingBox();
+            auto size = std::max(max.X.value - min.X.value, max.Y.value - min.Y.value) * lod.scale;
+            if (size < lod.minimum) {
+                continue;
+            }
+            if (points.size() > 4 && size < lod.primitive) {
+                result.push_back(stbox::Math::Rectangle(min, max.X.value - min.X.value, max.Y.value - min.Y.value));
+                continue;
+            }
+            if (points.size() > 3) {
+                auto simplified = stbox::Math::Point::simplify(points, lod.tolerance / lod.scale, true);
+                if (simplified.size() > 2 && simplified.size() < points.size()) {
+                    item.setup(simplified);
+                }
+            }
+            result.push_back(item);
+        }
+
+        return result;
+    }
+
+    // Returns SVG Elements with level of detail.
+    static auto join(const std::vector<stbox::Math::Base> &bases, const std::string &label,
+                     const LevelOfDetail &lod) -> std::string
+    {
+        return join(decimate(bases, lod), label);
+    }
+
+    // Returns SVG Elements inside the document (0,0)(width,height).
+    static auto join(const std::vector<stbox::Math::Base> &bases, const std::string &label,
+                     const int &width, const int &height, bool clip = false) -> std::string
+    {
+        return join(cull(bases, width, height, clip), label);
+    }
+
+    // Returns SVG Elements, repeated geometries written once (see SVG::instances).
+    static auto joinInstances(const std::vector<stbox::Math::Base> &bases, const std::string &label = "") -> std::string
+    {
+        std::vector<stbox::Image::SVG::NormalShape> shapes;
+        shapes.reserve(bases.size());
+        for (const auto &item : bases) {
+            shapes.push_back(normalShape(item, label));
+        }
+
+        return stbox::Image::SVG::instances(shapes);
+    }
+
+    // Returns SVG Elements with shared CSS classes, the registry collects the styles.
+    static auto join(const std::vector<stbox::Math::Base> &bases, const std::string &label,
+                     stbox::Image::StyleRegistry &registry) -> std::string
+    {
+        std::string strShape{};
+        for (const auto &item : bases) {
+            auto shape = normalShape(item, label);
+            shape.className = registry.add(shape);
+            strShape += stbox::Image::SVG::polygon(shape);
+        }
+
+        return strShape;
+    }
+
 };
 
 // Interpreter
@@ -541,7 +810,8 @@ public:
         return result;
     }
 
-    auto load(const std::string &path, std::string &errors) -> std::string
+    // Lines converted in parallel (threads 0 : hardware concurrency), same output for any number of threads.
+    auto load(const std::string &path, std::string &errors, unsigned threads = 1) -> std::string
     {
         auto text = stbox::Sys::IO::load(path, ".txt");
         if (text.empty()) {
@@ -549,23 +819,26 @@ public:
             return {};
         }
 
-        std::string result{};
         errors.clear();
         auto lines = stbox::Text::split(text, '\n');
-        for (unsigned i = 0; i < lines.size(); i++) {
-            auto line = lines[i];
+        std::vector<std::string> lineErrors(lines.size());
+        auto result = stbox::Image::SVG::elements(lines.size(), [&](size_t i, std::string &elements) {
+            const auto &line = lines[i];
             if (line.starts_with('#')) {
-                errors += std::to_string(i + 1) + ": [COMMENT LINE]\n";
-                continue;
+                lineErrors[i] = std::to_string(i + 1) + ": [COMMENT LINE]\n";
+                return;
             }
             std::string error{};
             auto res = svg(line, error);
             if (!res.empty()) {
-                result += res;
+                elements += res;
             }
             else {
-                errors += std::to_string(i + 1) + ": " + error;
+                lineErrors[i] = std::to_string(i + 1) + ": " + error;
             }
+        }, threads);
+        for (const auto &error : lineErrors) {
+            errors += error;
         }
 
         return result;
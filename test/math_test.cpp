@@ -3,6 +3,7 @@
 #include <iostream>
 #include <cassert>
 #include <numbers>
+#include <random>
 
 #define MAXNUMBER   std::numeric_limits<float>::max()
 #define PI          std::numbers::pi
@@ -22,6 +23,16 @@ void rectangle();
 void circle();
 void regularPolygons();
 void irregularPolygon();
+void clipping();
+void floatPrecision();
+void grid();
+void kdTree();
+void segmentBVH();
+void distanceField();
+void navigation();
+void arcLength();
+void curves();
+void offset();
 
 auto main() -> int
 {
@@ -34,6 +45,16 @@ auto main() -> int
     circle();
     regularPolygons();
     irregularPolygon();
+    clipping();
+    floatPrecision();
+    grid();
+    kdTree();
+    segmentBVH();
+    distanceField();
+    navigation();
+    arcLength();
+    curves();
+    offset();
 
     std::cout << "Math test finished!\n";
 }
@@ -81,7 +102,7 @@ void numbers()
     assert(Math::round(0.0109, 3) == 0.0110);
 
     assert(Math::triangleArea(0, 0, 5, 0, 0, 10) == 25.0);    // Triangle
-    assert(Math::triangleHeight(0, 0, 5, 0, 0, 10) == 10.0);  // Triangle
+    assert(Math::Point::triangleHeight({0, 0}, {5, 0}, {0, 10}) == 10.0);  // Triangle
 
     Numbers numbers {10, -1, 2};
     Numbers expected {-1, 2, 10};
@@ -158,6 +179,21 @@ void point()
     expected = { {-5, -1},  {-10, 0}, Math::Origin, {10, 0} };
     assert(Math::equal(points, expected, true) == true);
 
+    // Simplify
+    assert(Math::equal(Math::Point::simplify({ {0, 0}, {1, 0.1}, {2, 0}, {3, 0} }, 0.5), { {0, 0}, {3, 0} }, true) == true);
+    assert(Math::equal(Math::Point::simplify({ {0, 0}, {1, 0.1}, {2, 0}, {3, 0} }, 0.01),
+    { {0, 0}, {1, 0.1}, {2, 0}, {3, 0} }, true) == true);
+    assert(Math::Point::simplify({ {0, 0}, {5, 0}, {10, 0}, {10, 10}, {0, 10} }, 0.1, true).size() == 4);
+
+    // Welding
+    assert(Math::equal(Math::Point::weld({ {0, 0}, {0.05, 0}, {1, 0}, {1, 0.02}, {1, 1}, {0.01, 0.01} }, 0.1),
+                       { {0, 0}, {1, 0}, {1, 1}, {0, 0} }, true) == true);
+    assert(Math::equal(Math::Point::weld({ {0, 0}, {0.05, 0}, {1, 0}, {1, 0.02}, {1, 1}, {0.01, 0.01} }, 0.1, true),
+                       { {0, 0}, {1, 0}, {1, 1} }, true) == true);
+    assert(Math::equal(Math::Point::weld({ {0, 0}, {0, 0}, {-0.05, -0.05}, {0.5, 0} }, 0), { {0, 0}, {-0.05, -0.05}, {0.5, 0} }, true) == true);
+    assert(Math::Point::weld({ {-0.04, 0}, {0.04, 0} }, 0.1).size() == 1);     // Across cells
+    assert(Math::Point::weld({}, 0.1).empty() == true);
+
     // Total
     assert(Math::Point::total({ {1, 1},  {1, 1},  {1, 1} }) == Math::Point(3, 3));
 
@@ -322,6 +358,19 @@ void triangle()
 
     triangle.setup(Math::Origin,  {10, 0},  {0, 10});
     assert(triangle.perimeter() == 10 + 10 + std::sqrt(200));
+    assert(triangle.contains(Math::Point(5, 5)) == true);   // Boundary
+    assert(triangle.contains(Math::Point(1, 1)) == true);
+    assert(triangle.contains(Math::Point(6, 6)) == false);
+    assert(triangle.contains(Math::Point(-1, 1)) == false);
+    assert(Math::Triangle({0, 0}, {0, 10}, {10, 0}).contains(Math::Point(1, 1)) == true); // Clockwise
+    assert(Math::Triangle({0, 0}, {1, 1}, {2, 2}).contains(Math::Point(100, 100)) == false); // Flat
+    assert(Math::Triangle({0, 0}, {1, 1}, {2, 2}).contains(Math::Point(1.5, 1.5)) == true);
+    assert(Math::Triangle({0, 0}, {2, 2}, {1, 1}).contains(Math::Point(-1, -1)) == false);
+    assert(Math::Triangle({1, 1}, {1, 1}, {1, 1}).contains(Math::Point(1, 1)) == true);
+    assert(Math::Triangle({1, 1}, {1, 1}, {1, 1}).contains(Math::Point(2, 2)) == false);
+    assert(Math::Triangle({0, 0}, {1, 1}, {2, 2}).height() == 0);
+    assert(Math::Triangle({0, 0}, {4, 0}, {0, 3}).height() == 4);
+    assert(Math::Triangle({0, 0}, {4, 0}, {0, 3}).area() == 6);
 
     Math::Point a(1, 1), b(2, 2), c(3, 3), d(4, 4);
     assert(Math::Triangle(a, b, c).equal(Math::Triangle(b, a, c)) == true);     // Equal
@@ -373,6 +422,26 @@ void rectangle()
     assert(Math::Rectangle(a, b, c, d).round().area() == Math::Rectangle(d, a, b, c).round().area());
     assert(Math::Rectangle(a, b, c, d).round().perimeter() == Math::Rectangle(d, a, b, c).round().perimeter());
 
+    // Fast paths : axis-aligned, rotated and not rectangular.
+    rectangle.setup(Math::Point(0, 0), 20, 10);
+    assert(rectangle.contains(Math::Point(20, 10)) == true);
+    assert(rectangle.contains(Math::Point(10, 5)) == true);
+    assert(rectangle.contains(Math::Point(20.1, 5)) == false);
+    assert(rectangle.contains(Math::Point(10, -0.1)) == false);
+    assert(std::get<1>(rectangle.contains(std::vector<Math::Point>{{30, 30}, {1, 1}})) == true);
+
+    Math::Rectangle rotated(Math::Point(0, 0), Math::Point(3, 4), Math::Point(-1, 7), Math::Point(-4, 3));
+    assert(rotated.area() == 25);
+    assert(rotated.perimeter() == 20);
+    assert(rotated.contains(Math::Point(-0.5, 3.5)) == true);
+    assert(rotated.contains(Math::Point(3, 0)) == false);
+    assert(rotated.contains(Math::Point(-4, 0)) == false);
+
+    Math::Rectangle quadrilateral(Math::Point(0, 0), Math::Point(4, 0), Math::Point(3, 3), Math::Point(1, 3));
+    assert(quadrilateral.area() == Math::IrregularPolygon({{0, 0}, {4, 0}, {3, 3}, {1, 3}}).area());
+    assert(quadrilateral.contains(Math::Point(2, 1.5)) == true);
+    assert(quadrilateral.contains(Math::Point(0.2, 2.5)) == false);
+
     rectangle.setup(Math::Origin, {0, 10}, {10, 10}, {0, 10});
     assert(Math::equal(rectangle.intersect(Math::Rectangle({5, 5}, {15, 5}, {15, 15}, {5, 15}).points()), {{5, 10}, {10, 5}}) == true);
     assert(Math::equal(rectangle.intersect(Math::Rectangle({5, 5}, {10, 5}, {10, 15}, {5, 15}).points()),
@@ -401,6 +470,9 @@ void circle()
     assert(ellipse.contains(Math::Origin + Math::Point(-8, 0)) == true);
     assert(ellipse.contains(Math::Origin + Math::Point(0, -2)) == true);
     assert(ellipse.contains(Math::Point(8.1, 0)) == false);
+    assert(circle.contains(Math::Point(4, 0)) == true);
+    assert(circle.contains(Math::Point(2.8, 2.8)) == true);
+    assert(circle.contains(Math::Point(2.9, 2.9)) == false);
     assert(ellipse.contains(Math::Point(0, 2.1)) == false);
 
     assert(circle.contains(Math::Point(4, 0)) == true);
@@ -519,6 +591,61 @@ void irregularPolygon()
     assert(iPolygon.contains({11,  5}) == false);
     assert(iPolygon.contains({ 5, 11}) == false);
 
+    // Welding
+    iPolygon = Math::IrregularPolygon({ {0, 0}, {10, 0}, {10, 0.001}, {10, 10}, {0, 10}, {0.001, 0} });
+    assert(iPolygon.weld(0.01).size() == 4);
+    assert(iPolygon.area() == 100.0);
+    assert(iPolygon.fourth == Math::Point(0, 10));
+
+    // Self-intersections.
+    assert(iPolygon.isSimple() == true);
+    iPolygon = Math::IrregularPolygon({ {0, 0}, {10, 10}, {10, 0}, {0, 10} });       // Bow tie
+    assert(iPolygon.isSimple() == false);
+    assert((iPolygon.selfIntersections() == std::vector<std::array<size_t, 2> > {{0, 2}}));
+    iPolygon = Math::IrregularPolygon({ {0, 0}, {10, 0}, {10, 10}, {5, 0}, {0, 10} }); // Touching vertex
+    assert((iPolygon.selfIntersections(true) == std::vector<std::array<size_t, 2> > {{0, 2}, {0, 3}}));
+    iPolygon = Math::IrregularPolygon({ {0, 0}, {10, 0}, {5, 0}, {5, 5} });            // Collinear overlap
+    assert(iPolygon.isSimple() == false);
+    iPolygon = Math::IrregularPolygon({ {0, 0}, {10, 0}, {10, 0}, {5, 5}, {0, 0} });   // Repeated vertices
+    assert(iPolygon.isSimple() == true);
+
+    // Star-shaped polygons are simple : the sweep agrees with all pairs.
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(1, 100);
+    for (int test = 0; test < 50; ++test) {
+        std::vector<Math::Point> points;
+        for (int i = 0; i < 200; ++i) {
+            points.push_back(Math::Origin.position(i * 360.0 / 200, distribution(generator)));
+        }
+        iPolygon.setup(points);
+        assert(iPolygon.isSimple() == true);
+        std::swap(points[10], points[150]);
+        iPolygon.setup(points);
+        assert(iPolygon.isSimple() == false);
+        assert(iPolygon.selfIntersections(true).size() >= 2);
+        assert(iPolygon.selfIntersections().size() == 1);
+    }
+
+    // Strictly convex polygons : wedge binary search.
+    Math::Circle circle(Math::Origin, 10);
+    auto inner = 10 * std::cos(0.5 * std::numbers::pi / 180);
+    for (int angle = 0; angle < 360; angle += 7) {
+        auto direction = Math::Point(std::cos(angle * std::numbers::pi / 180), std::sin(angle * std::numbers::pi / 180));
+        assert(circle.Math::Base::contains(direction * (inner - 0.01)) == true);
+        assert(circle.Math::Base::contains(direction * 10.01) == false);
+    }
+    assert(circle.Math::Base::contains(Math::Point(10, 0)) == true);     // Vertex
+
+    iPolygon = Math::IrregularPolygon({ {0, 10}, {-10, 0}, {0, -10}, {10, 0} }); // Clockwise
+    assert(iPolygon.contains({ 0,  0}) == true);
+    assert(iPolygon.contains({ 5,  5}) == true);
+    assert(iPolygon.contains({-5, -5}) == true);
+    assert(iPolygon.contains({ 0, 11}) == false);
+    assert(iPolygon.contains({ 6,  6}) == false);
+    assert(iPolygon.contains({-6,  5}) == false);
+    iPolygon.first = {0, 20};   // Cache updated.
+    assert(iPolygon.contains({ 0, 15}) == true);
+
     iPolygon = Math::IrregularPolygon({ {-10, 0}, {10, 0}, {10, 0}, {0, -10} });
     assert(iPolygon.isConvex() == true);
     assert(Math::round(iPolygon.area(), 2) == 100.0);   // 100.00000000000001
@@ -556,3 +683,535 @@ void irregularPolygon()
     std::tie(result, status) = iPolygon2.contains(iPolygon1);
     assert(status == false);
 }
+
+void clipping()
+{
+    using namespace stbox;
+
+    auto area = [](std::vector<Math::Base> polygons) {
+        double total = 0;
+        for (auto &polygon : polygons) {
+            double signedArea = 0;
+            auto points = polygon.points();
+            for (unsigned i = 0; i < points.size(); ++i) {
+                auto &a = points[i];
+                auto &b = points[(i + 1) % points.size()];
+                signedArea += (a.X.value * b.Y.value - b.X.value * a.Y.value) / 2;
+            }
+            total += std::abs(signedArea);
+        }
+        return total;
+    };
+    // Holes subtracted.
+    auto signedArea = [](std::vector<Math::Base> polygons) {
+        double total = 0;
+        for (auto &polygon : polygons) {
+            auto points = polygon.points();
+            for (unsigned i = 0; i < points.size(); ++i) {
+                auto &a = points[i];
+                auto &b = points[(i + 1) % points.size()];
+                total += (a.X.value * b.Y.value - b.X.value * a.Y.value) / 2;
+            }
+        }
+        return total;
+    };
+
+    Math::Rectangle square1({0, 0}, 10, 10);
+    Math::Rectangle square2({5, 5}, 10, 10);
+    assert(Math::Clipping::intersection(square1, square2).size() == 1);
+    assert(Math::round(area(Math::Clipping::intersection(square1, square2)), 6) == 25.0);
+    assert(Math::Clipping::unite(square1, square2).size() == 1);
+    assert(Math::round(area(Math::Clipping::unite(square1, square2)), 6) == 175.0);
+    assert(Math::round(area(Math::Clipping::difference(square1, square2)), 6) == 75.0);
+    assert(Math::Clipping::exclusive(square1, square2).size() == 2);
+    assert(Math::round(area(Math::Clipping::exclusive(square1, square2)), 6) == 150.0);
+
+    // Disjoint and nested polygons.
+    Math::Rectangle square3({20, 20}, 5, 5);
+    Math::Rectangle square4({2, 2}, 2, 2);
+    assert(Math::Clipping::intersection(square1, square3).empty());
+    assert(Math::Clipping::unite(square1, square3).size() == 2);
+    assert(Math::Clipping::intersection(square1, square4).front().equal(square4));
+    assert(Math::Clipping::unite(square1, square4).front().equal(square1));
+    assert(Math::Clipping::difference(square4, square1).empty());
+
+    // Nested clip : a clockwise hole.
+    auto holed = Math::Clipping::difference(square1, square4);
+    assert(holed.size() == 2);
+    assert(!Math::Clipping::hole(holed[0]) && Math::Clipping::hole(holed[1]));
+    assert(Math::round(signedArea(holed), 6) == 96.0);
+
+    // Degenerate : shared edge.
+    Math::Rectangle square5({10, 0}, 10, 10);
+    assert(Math::Clipping::unite(square1, square5).size() == 1);
+    assert(Math::round(area(Math::Clipping::unite(square1, square5)), 3) == 200.0);
+    auto pair = Math::Clipping::unite(Math::Rectangle({0, 0}, 1, 1), Math::Rectangle({1, 0}, 1, 1));
+    assert(pair.size() == 1 && pair[0].points().size() == 4);
+    assert(Math::Clipping::intersection(square1, square5).empty());
+    assert(Math::round(area(Math::Clipping::difference(square1, square5)), 6) == 100.0);
+
+    // Degenerate : vertex on edge, overlapping edges, shared vertex.
+    Math::Rectangle square6({10, 2}, 5, 5);
+    auto tee = Math::Clipping::unite(square1, square6);
+    assert(tee.size() == 1 && tee[0].points().size() == 8);
+    assert(Math::round(area(tee), 6) == 125.0);
+    Math::Rectangle square7({10, 10}, 5, 5);
+    assert(Math::Clipping::unite(square1, square7).size() == 2);
+    assert(Math::Clipping::intersection(square1, square7).empty());
+
+    // Cascaded union.
+    std::vector<Math::Base> tiles;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            tiles.push_back(Math::Rectangle({i * 1.0, j * 1.0}, 1.5, 1.5));
+        }
+    }
+    tiles.push_back(Math::Rectangle({50, 50}, 1, 1));
+    auto outlines = Math::Clipping::unite(tiles);
+    assert(outlines.size() == 2);
+    assert(Math::round(area(outlines), 3) == 10.5 * 10.5 + 1);
+    assert(Math::round(area(Math::Clipping::unite(tiles, 1)), 3) == 10.5 * 10.5 + 1);
+
+    // Cascaded union of tiles sharing their edges exactly.
+    tiles.clear();
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            tiles.push_back(Math::Rectangle({i * 1.0, j * 1.0}, 1, 1));
+        }
+    }
+    for (unsigned threads : {1U, 4U}) {
+        outlines = Math::Clipping::unite(tiles, threads);
+        assert(outlines.size() == 1 && outlines[0].points().size() == 4);
+        assert(Math::round(signedArea(outlines), 6) == 100.0);
+    }
+
+    // Ring of tiles : outline and hole.
+    tiles.erase(tiles.begin() + 55);
+    outlines = Math::Clipping::unite(tiles);
+    assert(outlines.size() == 2);
+    assert(Math::round(signedArea(outlines), 6) == 99.0);
+    assert(Math::Clipping::hole(outlines[0]) != Math::Clipping::hole(outlines[1]));
+}
+
+void floatPrecision()
+{
+    using namespace stbox;
+
+    // Polygon vertices : half the memory in float.
+    static_assert(sizeof(Math::Vertex<float>) * 2 == sizeof(Math::Vertex<double>));
+
+    Math::PointF p1(1, 1), p2(4, 5);
+    assert(p1 + p2 == Math::PointF(5, 6));
+    assert(p2 * 0.5F == Math::PointF(2, 2.5));
+    assert(p1.distance(p2) == 5.0);
+    assert(p1.angle(Math::PointF(1, 2)) == 90);
+    assert(Math::PointF().position(90, 10).round() == Math::PointF(0, 10));
+
+    auto [result, status] = Math::PointF::lineIntersect(2, 2, 2, 10, 0, 4, 10, 4);
+    assert(status == 2);
+    assert(result == Math::PointF(2, 4));
+    auto sorted = Math::PointF::sort({ {3, 1}, {2, 1}, {1, 0} }, false);
+    assert(sorted[0] == Math::PointF(1, 0) && sorted[1] == Math::PointF(2, 1) && sorted[2] == Math::PointF(3, 1));
+    assert((Math::sort(std::vector<float> {3, 1, 2}) == std::vector<float> {1, 2, 3}));
+
+    Math::BaseF polygon;
+    polygon.setup({ {0, 0}, {10, 0}, {10, 10}, {0, 10} });
+    assert(polygon.isConvex() == true);
+    assert(polygon.area() == 100.0);
+    assert(polygon.perimeter() == 40.0);
+    assert(polygon.contains({5, 5}) == true);
+    assert(polygon.contains({11, 5}) == false);
+    auto [min, max] = polygon.boundingBox();
+    assert(min == Math::PointF(0, 0) && max == Math::PointF(10, 10));
+    assert(polygon.vertices().size() == 4);
+    assert(polygon.vertices()[2].x == 10.0F && polygon.vertices()[2].y == 10.0F);
+    polygon.third = Math::PointF(20, 20);
+    assert(polygon.vertices()[2].x == 20.0F);
+    assert(polygon.points()[2] == Math::PointF(20, 20));
+
+    // Same algorithms, same answers.
+    Math::Base reference;
+    reference.setup({ {-3, -2}, {-1, 4}, {6, 1}, {3, 10}, {-4, 9} });
+    polygon.setup({ {-3, -2}, {-1, 4}, {6, 1}, {3, 10}, {-4, 9} });
+    assert(polygon.area() == reference.area());
+    assert(polygon.isConvex() == reference.isConvex());
+}
+
+void grid()
+{
+    using namespace stbox;
+
+    using Cells = std::vector<Math::Grid::Cell>;
+
+    Math::Grid grid;
+    assert((grid.snap(Math::Point(1.4, -2.6)) == Math::Grid::Cell{1, -3}));
+    assert(grid.snap({ {0, 0}, {0.2, 0.1}, {10, 0}, {10, 10}, {0.3, -0.2} }).size() == 3);
+
+    Math::Grid half(0.5);
+    assert((half.snap(Math::Point(1.4, -2.6)) == Math::Grid::Cell{3, -5}));
+    assert(half.point({3, -5}) == Math::Point(1.5, -2.5));
+
+    // Exact predicates.
+    assert(Math::Grid::orientation({0, 0}, {10, 0}, {5, 1}) == 1);
+    assert(Math::Grid::orientation({0, 0}, {10, 0}, {5, -1}) == -1);
+    assert(Math::Grid::orientation({0, 0}, {10, 0}, {20, 0}) == 0);
+    assert(Math::Grid::intersect({0, 0}, {10, 10}, {0, 10}, {10, 0}) == true);
+    assert(Math::Grid::intersect({0, 0}, {10, 0}, {10, 0}, {10, 10}) == true);    // Touch.
+    assert(Math::Grid::intersect({0, 0}, {10, 0}, {11, 0}, {20, 0}) == false);
+    assert(Math::Grid::intersect({0, 0}, {10, 0}, {0, 1}, {10, 1}) == false);
+
+    auto polygon = grid.snap(Math::IrregularPolygon({ {-3, -2}, {-1, 4}, {6, 1}, {3, 10}, {-4, 9} }));
+    assert(Math::Grid::doubleArea(polygon) == 120);
+    for (auto cell : Cells{ {0, 5}, {5, 3}, {-3, 5}, {-2, 2}, {-3, 2}, {-3, -2}, {6, 1} }) {
+        assert(Math::Grid::contains(polygon, cell) == true);
+    }
+    for (auto cell : Cells{ {0, 3}, {2, 2}, {5, 5}, {-4, 2}, {-4, 5}, {10, 0} }) {
+        assert(Math::Grid::contains(polygon, cell) == false);
+    }
+
+    // Range limit : cross products beyond 64 bits.
+    const long long limit = (1LL << 30) - 1;
+    assert(Math::Grid::orientation({-limit, -limit}, {limit, -limit}, {limit, limit}) == 1);
+    assert(Math::Grid::orientation({-limit, -limit}, {limit, limit}, {limit - 1, limit}) == 1);
+    assert(Math::Grid::orientation({-limit, -limit}, {limit, limit}, {limit, limit - 1}) == -1);
+    assert(Math::Grid::doubleArea({ {-limit, -limit}, {limit, -limit}, {limit, limit}, {-limit, limit} }) == 8 * limit * limit);
+}
+
+void kdTree()
+{
+    using namespace stbox;
+
+    Points points;
+    for (int i = 0; i < 2000; ++i) {
+        points.emplace_back(Math::randomize(1000), Math::randomize(1000));
+    }
+    Math::KDTree tree(points);
+    assert(tree.size() == points.size());
+
+    // Brute force reference.
+    Math::Point query(500, 500);
+    std::vector<size_t> order(points.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return points[a].distance(query) < points[b].distance(query);
+    });
+
+    auto nearest = tree.nearest(query, 10);
+    assert(nearest.size() == 10);
+    for (size_t i = 0; i < nearest.size(); ++i) {
+        assert(points[nearest[i]].distance(query) == points[order[i]].distance(query));
+    }
+
+    auto inRadius = tree.radius(query, 50);
+    assert(inRadius.size() == static_cast<size_t>(std::count_if(points.begin(), points.end(), [&](auto & p) {
+        return p.distance(query) <= 50;
+    })));
+
+    auto inRange = tree.range({100, 200}, {300, 250});
+    assert(inRange.size() == static_cast<size_t>(std::count_if(points.begin(), points.end(), [](auto & p) {
+        return p.X.value >= 100 && p.X.value <= 300 && p.Y.value >= 200 && p.Y.value <= 250;
+    })));
+
+    // Batch : each point is its own nearest.
+    auto batch = tree.nearest(points, 1, 4);
+    for (size_t i = 0; i < points.size(); ++i) {
+        assert(points[batch[i].front()] == points[i]);
+    }
+    auto neighbours = tree.radius(Points{query}, 50, 2);
+    assert(neighbours.front().size() == inRadius.size());
+
+    assert(Math::KDTree().nearest(query).empty());
+    assert(Math::KDTree(Points{query}).nearest(query, 3).size() == 1);
+
+    // No neighbour asked.
+    assert(tree.nearest(query, 0).empty());
+    batch = tree.nearest(points, 0, 4);
+    assert(batch.size() == points.size() && batch.front().empty() && batch.back().empty());
+}
+
+void segmentBVH()
+{
+    using namespace stbox;
+
+    Math::SegmentBVH square(Math::Rectangle({0, 0}, 10, 10));
+    auto [point, distance, edge] = square.closest({5, -3});
+    assert(point == Math::Point(5, 0));
+    assert(distance == 3);
+    assert(edge == 0);
+    assert(square.signedDistance({5, 4}) == -4);
+    assert(square.signedDistance({13, 14}) == 5);
+    assert(square.signedDistance({10, 5}) == 0);
+
+    // Line : unsigned distance.
+    Math::SegmentBVH line(Math::Line({0, 0}, {10, 0}));
+    assert(line.distance({-3, 4}) == 5);
+    assert(line.signedDistance({5, 1}) == 1);
+
+    // Brute force reference.
+    Math::IrregularPolygon polygon(Math::RegularPolygon({0, 0}, 100, 0, 180).points());
+    auto vertices = polygon.points();
+    Math::SegmentBVH tree(polygon);
+    for (int i = 0; i < 200; ++i) {
+        Math::Point p(Math::randomize(300) - 150, Math::randomize(300) - 150);
+        double expected = std::numeric_limits<double>::max();
+        for (unsigned j = 0; j < vertices.size(); ++j) {
+            Math::SegmentBVH edge(Math::Line(vertices[j], vertices[(j + 1) % vertices.size()]));
+            expected = std::min(expected, edge.distance(p));
+        }
+        assert(Math::round(tree.distance(p), 9) == Math::round(expected, 9));
+        if (p.distance(Math::Origin) < 99 || p.distance(Math::Origin) > 100) {
+            assert(tree.contains(p) == (p.distance(Math::Origin) < 99));
+        }
+    }
+
+    // Batch
+    auto grid = square.signedDistance({-5, -5}, 21, 21, 1.0, 3);
+    assert(grid.size() == 21 * 21);
+    assert(grid[0] == std::sqrt(50));
+    assert(grid[10 * 21 + 10] == -5);
+    assert(grid[5 * 21 + 10] == 0);
+}
+
+void distanceField()
+{
+    using namespace stbox;
+
+    Math::DistanceField field(Math::Point(0, 0), 100, 80, 1.0);
+    field.generate({Math::Circle({20, 20}, 10), Math::Ellipse({60, 40}, 20, 10)},
+                   {Math::Rectangle({10, 50}, 20, 20)}, 3);
+    assert(field.values.size() == 100 * 80);
+    assert(field.at(20, 20) == -10);         // Circle center.
+    assert(field.at(35, 20) == 5);           // Circle.
+    assert(field.at(60, 40) == -10);         // Ellipse center.
+    assert(field.at(85, 40) == 5);           // Ellipse.
+    assert(std::abs(field.at(60, 55) - 5) < 1e-5);
+    assert(field.at(20, 60) == -10);         // Rectangle center.
+    assert(field.at(20, 75) == 5);           // Rectangle.
+
+    // Ellipse : compared with dense sampling.
+    Math::Ellipse ellipse({0, 0}, 30, 10);
+    Math::DistanceField sample(Math::Point(-45, -25), 10, 10, 9.0);
+    sample.generate({ellipse}, {});
+    for (size_t row = 0; row < sample.rows; ++row) {
+        for (size_t column = 0; column < sample.columns; ++column) {
+            auto p = sample.position(column, row);
+            double expected = std::numeric_limits<double>::max();
+            for (int i = 0; i < 20000; ++i) {
+                auto a = 2 * PI * i / 20000;
+                expected = std::min(expected, p.distance({30 * std::cos(a), 10 * std::sin(a)}));
+            }
+            expected = ellipse.contains(p) ? -expected : expected;
+            assert(std::abs(sample.at(column, row) - expected) < 1e-2);
+        }
+    }
+
+    // Distance transform from the mask.
+    Math::DistanceField mask(Math::Point(0, 0), 40, 30, 0.5);
+    std::vector<bool> inside(40 * 30, false);
+    for (size_t row = 10; row < 20; ++row) {
+        for (size_t column = 10; column < 30; ++column) {
+            inside[row * 40 + column] = true;
+        }
+    }
+    mask.generate(inside);
+    assert(mask.at(0, 0) == 0.5F * std::sqrt(200.0F));
+    assert(mask.at(20, 15) == -0.5F * 5);
+    assert(mask.at(20, 5) == 0.5F * 5);
+    assert(mask.at(10, 10) == -0.5F);
+    assert(mask.at(9, 10) == 0.5F);
+}
+
+void navigation()
+{
+    using namespace stbox;
+
+    Math::Navigation navigation({Math::Rectangle({10, 0}, 10, 10)});
+    Math::Navigation::Query query;
+
+    // Free path.
+    auto path = navigation.path({0, 20}, {30, 20}, query);
+    assert(path.size() == 2);
+
+    // Around the obstacle.
+    path = navigation.path({0, 5}, {30, 5}, query);
+    assert(path.size() == 4);
+    assert(Math::round(Math::Point::sumDistances(path), 6) == Math::round(2 * std::sqrt(125.0) + 10, 6));
+
+    // Along the boundary.
+    path = navigation.path({10, 15}, {20, 15}, query);
+    assert(path.size() == 2);
+
+    // Start inside an obstacle.
+    assert(navigation.path({15, 5}, {30, 5}, query).empty());
+
+    // Concave obstacle (U shape) : reflex vertices are not nodes.
+    Math::Navigation maze({
+        Math::IrregularPolygon({ {0, 0}, {30, 0}, {30, 30}, {20, 30}, {20, 10}, {10, 10}, {10, 30}, {0, 30} })
+    });
+    path = maze.path({15, 20}, {15, -10}, query);
+    assert(path.size() == 5);
+    assert(path[1] == Math::Point(10, 30) || path[1] == Math::Point(20, 30));
+    assert(Math::round(Math::Point::sumDistances(path), 6) ==
+           Math::round(std::sqrt(125.0) + 10 + 30 + std::sqrt(325.0), 6));
+
+    // Memory reused by many queries.
+    for (int i = 0; i < 100; ++i) {
+        assert(!navigation.path({0, 5.0 + i * 0.01}, {30, 5}, query).empty());
+    }
+
+    // Overlapping obstacles : the path bends at their vertices only.
+    Math::Navigation overlap({Math::Rectangle({10, 0}, 10, 10), Math::Rectangle({15, 5}, 10, 10)});
+    path = overlap.path({0, 5}, {30, 5}, query);
+    assert(path.size() == 4);
+    assert(Math::round(Math::Point::sumDistances(path), 6) == Math::round(2 * std::sqrt(125.0) + 10, 6));
+    path = overlap.path({0, 12}, {30, 12}, query);
+    assert(path.size() == 4);
+    assert(Math::round(Math::Point::sumDistances(path), 6) == Math::round(std::sqrt(234.0) + 10 + std::sqrt(34.0), 6));
+
+    // The edges of an obstacle are visible, whatever the rounding of their midpoints.
+    Math::RegularPolygon pentagon({36.3, 17.9}, 7.7, 0, 5);
+    Math::Navigation around({pentagon});
+    auto vertices = pentagon.points();
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        assert(around.visible(vertices[i], vertices[(i + 1) % vertices.size()]));
+        assert(!around.visible(vertices[i], vertices[(i + 2) % vertices.size()]));
+    }
+}
+
+void arcLength()
+{
+    using namespace stbox;
+
+    // Open path.
+    Math::ArcLength path({ {0, 0}, {10, 0}, {10, 10}, {10, 10}, {0, 10} });
+    assert(path.length() == 30);
+    assert(path.at(-1) == Math::Point(0, 0));
+    assert(path.at(5) == Math::Point(5, 0));
+    assert(path.at(15) == Math::Point(10, 5));
+    assert(path.at(25) == Math::Point(5, 10));
+    assert(path.at(40) == Math::Point(0, 10));
+    assert(path.angle(5) == 0);
+    assert(path.angle(15) == 90);
+    assert(path.angle(20) == 180);   // After the repeated vertex.
+
+    auto points = path.resample(7);
+    assert(points.size() == 7);
+    assert(points[1] == Math::Point(5, 0));
+    assert(points[3] == Math::Point(10, 5));
+    assert(points[6] == Math::Point(0, 10));
+
+    // Closed outline.
+    Math::ArcLength outline(Math::Rectangle(Math::Origin, 10, 10));
+    assert(outline.length() == 40);
+    assert(outline.at(35) == Math::Point(0, 5));
+    points = outline.resample(8);
+    assert(points.size() == 8);
+    assert(points.back() == Math::Point(0, 5));
+
+    // Resampling agrees with the lookups.
+    Math::ArcLength circle(Math::Circle(Math::Origin, 50));
+    points = circle.resample(1000);
+    for (size_t i = 0; i < points.size(); ++i) {
+        auto p = circle.at(i * circle.length() / 1000);
+        assert(Math::round(points[i].distance(p), 9) == 0);
+    }
+
+    // Degenerate paths.
+    assert(Math::ArcLength().resample(3).empty() == true);
+    assert(Math::ArcLength({ {1, 1} }).resample(2).size() == 2);
+    assert(Math::ArcLength({ {1, 1} }).at(5) == Math::Point(1, 1));
+}
+
+void curves()
+{
+    using namespace stbox;
+
+    // Flattening error within the tolerance (segment midpoints against the curve).
+    for (const auto &curve : {Math::Bezier({0, 0}, {50, 100}, {100, 0}),
+                              Math::Bezier({0, 0}, {0, 100}, {100, 100}, {100, 0}),
+                              Math::Bezier({0, 0}, {300, 50}, {-200, 50}, {100, 0})}) {
+        for (auto tolerance : {1.0, 0.1, 0.01}) {
+            auto points = curve.flatten(tolerance);
+            auto count = points.size() - 1;
+            assert(count == curve.segments(tolerance));
+            assert(points.front() == curve.start());
+            assert(points.back() == curve.end());
+            for (size_t i = 0; i < count; ++i) {
+                assert(points[i].distance(curve.at(static_cast<double>(i) / count)) < 1e-6);
+                auto middle = (points[i] + points[i + 1]) * 0.5;
+                assert(middle.distance(curve.at((i + 0.5) / count)) <= tolerance);
+            }
+        }
+    }
+    assert(Math::Bezier({0, 0}, {5, 5}, {10, 10}).flatten(0.1).size() == 2);     // Straight
+    assert(Math::Bezier({0, 0}, {50, 100}, {100, 0}).segments(0.01) > Math::Bezier({0, 0}, {50, 100}, {100, 0}).segments(1));
+
+    // Arcs.
+    Math::Arc arc({10, 10}, 50, 50, 30, 120);
+    assert(Math::round(arc.start().distance(Math::Point(10, 10).position(30, 50)), 9) == 0);
+    assert(arc.largeArc() == false && arc.sweep() == true);
+    assert(Math::Arc({0, 0}, 5, 5, 0, -200).largeArc() == true);
+    assert(Math::Arc({0, 0}, 5, 5, 0, -200).sweep() == false);
+    auto points = arc.flatten(0.05);
+    assert(points.back() == arc.end());
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        assert(Math::round(points[i].distance({10, 10}), 9) == 50);
+        assert(50 - ((points[i] + points[i + 1]) * 0.5).distance({10, 10}) <= 0.05);
+    }
+
+    // Rotated ellipse.
+    Math::Arc ellipse({0, 0}, 20, 10, 0, 360, 90);
+    assert(Math::round(ellipse.start().distance({0, 20}), 9) == 0);
+    assert(Math::round(ellipse.flatten(0.1).back().distance(ellipse.start()), 9) == 0);
+}
+
+void offset()
+{
+    using namespace stbox;
+
+    auto area = [](Math::Base base) {
+        return Math::round(std::abs(Math::IrregularPolygon(base.points()).area()), 6);
+    };
+
+    // Polygon joins.
+    Math::Rectangle square(Math::Origin, 10, 10);
+    assert(area(Math::Offset::polygon(square, 1)) == 144);
+    assert(area(Math::Offset::polygon(square, 1, Math::Offset::BEVEL)) == 142);
+    assert(Math::round(area(Math::Offset::polygon(square, 1, Math::Offset::ROUND, 4, 0.001)), 1) == Math::round(140 + std::numbers::pi, 1));
+    assert(area(Math::Offset::polygon(square, -1)) == 64);
+    assert(area(Math::Offset::polygon(Math::IrregularPolygon(Math::Point::organize(square.points())), 1)) == 144); // Orientation
+    assert(Math::Offset::polygon(Math::Triangle({0, 0}, {100, 0}, {0, 1}), 1, Math::Offset::MITER, 4).points().size() == 4); // Miter limit
+
+    // Concave polygon : the inner corner is trimmed.
+    Math::IrregularPolygon l({ {0, 0}, {20, 0}, {20, 10}, {10, 10}, {10, 20}, {0, 20} });
+    auto grown = Math::Offset::polygon(l, 1);
+    assert(grown.points().size() == 6);
+    assert(grown.contains(Math::Point(11.5, 11.5)) == false);
+    assert(grown.points()[3] == Math::Point(11, 11));
+    assert(grown.contains(Math::Point(10.5, 10.5)) == true);
+
+    // Polyline stroke : butt or round caps.
+    std::vector<Math::Point> segment{ {0, 0}, {10, 0} };
+    assert(area(Math::Offset::stroke(segment, 2)) == 20);
+    assert(Math::round(area(Math::Offset::stroke(segment, 2, Math::Offset::ROUND, 4, 0.001)), 1) == Math::round(20 + std::numbers::pi, 1));
+
+    // Hit tests.
+    auto outline = Math::Offset::stroke(std::vector<Math::Point>{ {0, 0}, {10, 0}, {10, 10} }, 2);
+    assert(outline.contains(Math::Point(5, 0.9)) == true);
+    assert(outline.contains(Math::Point(10.9, -0.9)) == true);   // Miter
+    assert(outline.contains(Math::Point(5, 1.1)) == false);
+    assert(outline.contains(Math::Point(-0.1, 0)) == false);    // Butt cap
+    assert(outline.contains(Math::Point(9.5, 5)) == true);
+
+    auto ring = Math::Offset::stroke(square, 2);
+    assert(ring.size() == 2);
+    auto onStroke = [&](const Math::Point &point) {
+        return ring[0].contains(point) && !ring[1].contains(point);
+    };
+    assert(onStroke({0.5, 5}) == true);
+    assert(onStroke({-0.5, 5}) == true);
+    assert(onStroke({5, 5}) == false);
+    assert(onStroke({-1.5, 5}) == false);
+}
@@ -4,12 +4,30 @@
 
 #include <cassert>
 #include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 
 // Tests
 void color();
 void svg();
+void culling();
+void levelOfDetail();
+void integerGrid();
+void distanceField();
+void curves();
+void writer();
+void formatting();
+void compactPath();
+void styleRegistry();
+void instancing();
+void clones();
+void document();
+void patch();
+void parallel();
 void interpreter();
 void loadTxt();
 
@@ -18,6 +36,20 @@ auto main() -> int
     // Sequence
     color();
     svg();
+    culling();
+    levelOfDetail();
+    integerGrid();
+    distanceField();
+    curves();
+    writer();
+    formatting();
+    compactPath();
+    styleRegistry();
+    instancing();
+    clones();
+    document();
+    patch();
+    parallel();
     interpreter();
     loadTxt();
 
@@ -26,6 +58,54 @@ auto main() -> int
     return 0;
 }
 
+// Reads path data back : M, L, H, V (absolute and relative), implicit commands and Z.
+auto parsePath(const std::string &d) -> std::vector<std::array<double, 2> >
+{
+    std::vector<std::array<double, 2> > points;
+    std::array<double, 2> pen{0, 0};
+    char command = 0;
+    size_t i = 0;
+    auto value = [&]() {
+        while (d[i] == ' ') {
+            ++i;
+        }
+        size_t end = i + (d[i] == '-' ? 1 : 0);
+        bool dot = false;
+        while (end < d.size() && (std::isdigit(d[end]) || (d[end] == '.' && !dot))) {
+            dot = dot || d[end] == '.';
+            ++end;
+        }
+        auto result = std::stod(d.substr(i, end - i));
+        i = end;
+        return result;
+    };
+    while (i < d.size()) {
+        if (d[i] == ' ') {
+            ++i;
+            continue;
+        }
+        if (std::isalpha(d[i])) {
+            command = d[i++];
+            if (command == 'Z') {
+                break;
+            }
+            continue;
+        }
+        switch (command) {
+        case 'M': case 'L': pen[0] = value(); pen[1] = value(); command = 'L'; break;
+        case 'l': pen[0] += value(); pen[1] += value(); break;
+        case 'H': pen[0] = value(); break;
+        case 'h': pen[0] += value(); break;
+        case 'V': pen[1] = value(); break;
+        case 'v': pen[1] += value(); break;
+        default: assert(false);
+        }
+        points.push_back(pen);
+    }
+
+    return points;
+}
+
 void color()
 {
     using namespace stbox;
@@ -78,6 +158,645 @@ void svg()
     Sys::IO::save(svg, "Resources/svgOutput1.svg");
 }
 
+void culling()
+{
+    using namespace stbox;
+
+    Math::Rectangle inside({10, 10}, 20, 20);
+    Math::Rectangle outside({200, 10}, 20, 20);
+    Math::Rectangle partial({90, 90}, 20, 20);
+    Math::Triangle triangle({-10, 50}, {-50, 50}, {-30, 10});
+
+    assert(Sketch::visible(inside, 100, 100) == true);
+    assert(Sketch::visible(outside, 100, 100) == false);
+    assert(Sketch::visible(partial, 100, 100) == true);
+    assert(Sketch::visible(triangle, 100, 100) == false);
+    assert(Sketch::visible(Math::Circle({-5, 50}, 10), 100, 100) == true);
+    assert(Sketch::visible(Math::Circle({-15, 50}, 10), 100, 100) == false);
+
+    // Bounding box is updated after modification.
+    auto [min, max] = inside.boundingBox();
+    assert(min == Math::Point(10, 10) && max == Math::Point(30, 30));
+    inside.first = Math::Point(0, 5);
+    std::tie(min, max) = inside.boundingBox();
+    assert(min == Math::Point(0, 5) && max == Math::Point(30, 30));
+
+    std::vector<Math::Base> shapes{inside, outside, partial, triangle};
+    assert(Sketch::cull(shapes, 100, 100).size() == 2);
+
+    auto clipped = Sketch::cull(shapes, 100, 100, true);
+    assert(clipped.size() == 2);
+    assert(Math::round(clipped.back().area(), 6) == 100);
+
+    assert(Sketch::join(shapes, "", 100, 100) == Sketch::join({inside, partial}));
+
+    // Hole of a difference : one path, even-odd rule.
+    auto region = Sketch::svgRegion(Math::Clipping::difference(Math::Rectangle({0, 0}, 10, 10),
+                                                               Math::Rectangle({2, 2}, 2, 2)), "Region");
+    assert(region.find("fill-rule=\"evenodd\"\nd=\"M ") != std::string::npos);
+    assert(std::count(region.begin(), region.end(), 'M') == 2 && std::count(region.begin(), region.end(), 'Z') == 2);
+    assert(Sketch::svgRegion({}, "Region") == "<!-- Empty -->\n");
+}
+
+void levelOfDetail()
+{
+    using namespace stbox;
+
+    std::vector<Math::Base> shapes {
+        Math::Circle({10, 10}, 1),                  // Removed.
+        Math::Circle({20, 20}, 4),                  // Rectangle.
+        Math::Circle({50, 50}, 40),                 // Simplified.
+        Math::Triangle({0, 0}, {10, 0}, {0, 10})    // Kept.
+    };
+
+    auto result = Sketch::decimate(shapes, Sketch::LevelOfDetail(0.2));
+    assert(result.size() == 3);
+    assert(result[0].points().size() == 4);
+    assert(result[1].points().size() > 3);
+    assert(result[1].points().size() < 360);
+    assert(result[2].points().size() == 3);
+    assert(Sketch::decimate(shapes, Sketch::LevelOfDetail(0.01)).size() == 1);
+
+    assert(Sketch::join(shapes, "", Sketch::LevelOfDetail(0.2)).size() < Sketch::join(shapes).size());
+}
+
+void integerGrid()
+{
+    using namespace stbox;
+
+    auto svg = Sketch::svgPolygon(Math::Grid(), Math::Rectangle({0.2, -0.1}, 9.9, 10.2), "Grid",
+                                  Image::Color::RGBA(255, 0, 0), Image::Color::RGBA(0, 0, 255));
+    assert(svg.find("d=\"M 0 0 L 10 0 L 10 10 L 0 10 Z\"") != std::string::npos);
+
+    svg = Sketch::svgPolygon(Math::Grid(0.5), Math::Rectangle({0.2, -0.1}, 9.9, 10.2), "Grid",
+                             Image::Color::RGBA(255, 0, 0), Image::Color::RGBA(0, 0, 255));
+    assert(svg.find("d=\"M 0 0 L 10 0 L 10 10 L 0 10 Z\"") != std::string::npos);
+
+    // Exact decimal multiples of the step.
+    svg = Sketch::svgPolygon(Math::Grid(0.25), Math::Rectangle({0.2, -0.1}, 9.9, 10.2), "Grid",
+                             Image::Color::RGBA(255, 0, 0), Image::Color::RGBA(0, 0, 255));
+    assert(svg.find("d=\"M 0.25 0 L 10 0 L 10 10 L 0.25 10 Z\"") != std::string::npos);
+    svg = Sketch::svgPolygon(Math::Grid(0.1), Math::Rectangle({0.2, -0.1}, 9.9, 10.2), "Grid",
+                             Image::Color::RGBA(255, 0, 0), Image::Color::RGBA(0, 0, 255));
+    assert(svg.find("d=\"M 0.2 -0.1 L 10.1 -0.1 L 10.1 10.1 L 0.2 10.1 Z\"") != std::string::npos);
+
+    std::string text;
+    Image::SVG::fixed(text, -5, 3);
+    text += ' ';
+    Image::SVG::fixed(text, 123456, 2);
+    text += ' ';
+    Image::SVG::fixed(text, 1200, 2);
+    assert(text == "-0.005 1234.56 12");
+}
+
+void distanceField()
+{
+    using namespace stbox;
+
+    Math::DistanceField field(Math::Point(0, 0), 60, 60, 10);
+    field.generate({Math::Circle({300, 300}, 150)}, {Math::Triangle({50, 550}, {250, 550}, {150, 400})});
+
+    auto svg = Sketch::svgDistanceField(field, "SDF", 100);
+    assert(svg.starts_with("<g id=\"SDF\" >"));
+    assert(std::count(svg.begin(), svg.end(), '\n') == 60 * 60 + 2);
+    assert(svg.find("fill:#000000") != std::string::npos);   // Circle center.
+
+    Sys::IO::save(Sketch::svg(600, 600, svg, Sketch::Metadata()), "Resources/svgOutput3.svg");
+}
+
+void curves()
+{
+    using namespace stbox;
+
+    Math::Bezier quadratic({0, 0}, {50, 100}, {100, 0});
+    auto svg = Sketch::svgBezier(quadratic, "Quadratic");
+    assert(svg.find("d=\"M 0 0 Q 50 100 100 0\"") != std::string::npos);
+
+    Math::Bezier cubic({0, 0}, {0, 100}, {100, 100}, {100, 0});
+    svg = Sketch::svgBezier(cubic, "Cubic");
+    assert(svg.find(" C 0 100 100 100 100 0\"") != std::string::npos);
+    // Fewer bytes than the flattened curve.
+    assert(svg.size() < Sketch::svgPolyline(Math::IrregularPolygon(cubic.flatten(0.1)), "Cubic").size());
+
+    // Quarter, large and full arcs.
+    svg = Sketch::svgArc(Math::Arc({0, 0}, 10, 10, 0, 90), "Arc");
+    assert(svg.find("d=\"M 10 0 A 10 10 0 0 1 0 10\"") != std::string::npos);
+    svg = Sketch::svgArc(Math::Arc({0, 0}, 10, 10, 0, -270), "Arc");
+    assert(svg.find(" 1 0 ") != std::string::npos);
+    svg = Sketch::svgArc(Math::Arc({0, 0}, 20, 10, 0, 360), "Ellipse");
+    assert(std::count(svg.begin(), svg.end(), 'A') == 2);
+
+    // Invalid curves.
+    assert(Image::SVG::bezier(Image::SVG::NormalShape("Curve", "none", "#000000", 1, {{0, 0}, {1, 1}, {2, 2}})) == "<!-- Empty -->\n");
+    assert(Image::SVG::arc(Image::SVG::ArcShape()) == "<!-- Empty -->\n");
+}
+
+void writer()
+{
+    using namespace stbox;
+
+    std::vector<Math::Base> shapes;
+    for (int i = 0; i < 200; ++i) {
+        shapes.push_back(Math::RegularPolygon({10.0 + i, 10.0 + i}, 5, 0, 3 + i % 5));
+    }
+    Image::SVG::Metadata metadata;
+    metadata.date = "2000";
+
+    // Same bytes as SVG::svg, with a buffer smaller than the document.
+    std::string xml;
+    std::ostringstream stream;
+    {
+        Image::SvgWriter writer(stream, 300, 300, metadata, 1024);
+        for (const auto &shape : shapes) {
+            auto element = Sketch::svgPolygon(shape, "P");
+            xml += element;
+            writer.write(element);
+        }
+        writer.circle(Image::SVG::CircleShape("C", "#FF0000", "#000000", 1, {50, 50}, 10, 10));
+        xml += Image::SVG::circle(Image::SVG::CircleShape("C", "#FF0000", "#000000", 1, {50, 50}, 10, 10));
+        assert(stream.str().size() < writer.size());         // Partially written.
+        assert(writer.size() - stream.str().size() <= 1024);  // Bounded buffer.
+    }
+    auto expected = Image::SVG::svg(300, 300, xml, metadata);
+    assert(stream.str() == expected);
+
+    // Closed writer ignores elements.
+    std::ostringstream empty;
+    Image::SvgWriter writer(empty, 10, 10, metadata);
+    writer.close();
+    writer.write("<g />");
+    assert(empty.str() == Image::SVG::svg(10, 10, "", metadata));
+    assert(writer.good() == true);
+}
+
+void formatting()
+{
+    using namespace stbox;
+
+    assert(Image::SVG::number(12.0) == "12");
+    assert(Image::SVG::number(0.5) == "0.5");
+    assert(Image::SVG::number(-1.25) == "-1.25");
+    assert(Image::SVG::number(-1e-9) == "0");
+    assert(Image::SVG::number(1.0 / 3) == "0.333333");
+    assert(Image::SVG::number(1e20) == "100000000000000000000");
+
+    // Configurable precision.
+    Image::SVG::Format format{2, true, false};
+    assert(Image::SVG::number(1.0 / 3, format) == "0.33");
+    assert(Image::SVG::number(2.999, format) == "3");
+    format.trim = false;
+    assert(Image::SVG::number(2.5, format) == "2.50");
+    format.precision = -1;     // Shortest round trip.
+    assert(std::stod(Image::SVG::number(0.1 + 0.2, format)) == 0.1 + 0.2);
+    assert(Image::SVG::number(0.1, format) == "0.1");
+    assert(Image::SVG::number(1.0 / 3) == "0.333333");
+
+    // Separated points, shorter than std::to_string.
+    Image::SVG::NormalShape shape("Line", "none", "#000000", 1.5, {{0, 0}, {10.5, 20}, {30, 40}});
+    auto svg = Image::SVG::polyline(shape);
+    assert(svg.find("points=\"0 0 10.5 20 30 40\"") != std::string::npos);
+    assert(svg.find("stroke-width:1.5;") != std::string::npos);
+    assert(Image::SVG::circle(Image::SVG::CircleShape("C", "#FF0000", "#000000", 1, {50, 50}, 10, 5)).find(
+               "cx=\"50\" cy=\"50\" rx=\"10\" ry=\"5\"") != std::string::npos);
+}
+
+void compactPath()
+{
+    using namespace stbox;
+
+    assert(Image::SVG::path({{0, 0}, {10, 0}, {10, 10}, {0, 10}}, true) == "M0 0H10V10H0Z");
+    assert(Image::SVG::path({{100, 100}, {101, 102}, {102.5, 103}}, false) == "M100 100l1 2 1.5 1");
+    assert(Image::SVG::path({{0.5, 0.5}, {1.5, 0.25}}, false) == "M.5.5l1-.25");
+    assert(Image::SVG::path({{100.25, 100.5}, {1, 2}}, false) == "M100.25 100.5 1 2");
+    assert(Image::SVG::path({{-1, -2}, {-3, -4}}, false) == "M-1-2-3-4");
+
+    // Round trip within the precision.
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> distribution(-500, 500);
+    std::vector<std::array<double, 2> > points;
+    for (int i = 0; i < 2000; ++i) {
+        auto x = i % 3 == 0 ? (points.empty() ? 0 : points.back()[0]) : distribution(generator);
+        auto y = i % 5 == 0 ? (points.empty() ? 0 : points.back()[1]) : distribution(generator);
+        points.push_back({x, y});
+    }
+    for (auto precision : {0, 2, 6}) {
+        auto d = Image::SVG::path(points, false, Image::SVG::Format{precision, true, false});
+        auto parsed = parsePath(d);
+        assert(parsed.size() <= points.size());
+        size_t k = 0;
+        for (const auto &point : points) {
+            auto scale = std::pow(10.0, precision);
+            std::array<double, 2> rounded{std::round(point[0] * scale) / scale, std::round(point[1] * scale) / scale};
+            if (k < parsed.size() && std::abs(parsed[k][0] - rounded[0]) < 1e-6 && std::abs(parsed[k][1] - rounded[1]) < 1e-6) {
+                ++k;
+            }
+        }
+        assert(k == parsed.size());
+        assert(k + 1 >= points.size() / 2);
+    }
+
+    // Polygon and polyline elements, smaller than the default encoding.
+    Image::SVG::NormalShape shape("Shape", "none", "#000000", 1, points);
+    const Image::SVG::Format format{6, true, true};
+    auto normal = Image::SVG::polygon(shape);
+    auto compact = Image::SVG::polygon(shape, format);
+    assert(compact.size() < normal.size());
+    assert(compact.find("Z\" />") != std::string::npos);
+    assert(Image::SVG::polyline(shape, format).starts_with("<path"));
+    assert(Image::SVG::polyline(shape).starts_with("<polyline"));
+
+    // The writer uses its own format.
+    std::ostringstream stream;
+    {
+        Image::SvgWriter writer(stream, 100, 100, Image::SVG::Metadata(), 1024, format);
+        writer.polygon(shape);
+    }
+    assert(stream.str().find(compact) != std::string::npos);
+}
+
+void styleRegistry()
+{
+    using namespace stbox;
+
+    Image::StyleRegistry registry;
+    Image::SVG::NormalShape red("A", "#FF0000", "#000000", 1);
+    Image::SVG::NormalShape blue("B", "#0000FF", "#000000", 1);
+    assert(registry.add(red) == "s0");
+    assert(registry.add(blue) == "s1");
+    red.name = "C";
+    assert(registry.add(red) == "s0");      // The name is not part of the style.
+    red.strokeWidth = 2;
+    assert(registry.add(red) == "s2");
+    assert(registry.size() == 3);
+
+    auto css = registry.css();
+    assert(css.starts_with("<style>\n.s0{opacity:1;fill:#FF0000;stroke:#000000;stroke-width:1;"));
+    assert(css.ends_with("}\n</style>\n"));
+
+    red.points = {{0, 0}, {1, 1}};
+    red.className = registry.add(red);
+    auto svg = Image::SVG::polygon(red);
+    assert(svg.find("class=\"s2\"") != std::string::npos);
+    assert(svg.find("style=") == std::string::npos);
+
+    // Uniform scene : one class, smaller output.
+    std::vector<Math::Base> shapes;
+    for (int i = 0; i < 100; ++i) {
+        shapes.push_back(Math::Rectangle({i * 2.0, i * 3.0}, 10, 10));
+    }
+    registry.clear();
+    auto classes = Sketch::join(shapes, "R", registry);
+    assert(registry.size() == 1);
+    assert(registry.css().size() + classes.size() < Sketch::join(shapes, "R").size());
+    Sys::IO::save(Sketch::svg(600, 600, registry.css() + classes, Sketch::Metadata()), "Resources/svgOutput4.svg");
+}
+
+void instancing()
+{
+    using namespace stbox;
+
+    // Tiles : one geometry moved and rotated, and a unique shape.
+    std::vector<Math::Base> shapes;
+    for (int i = 0; i < 50; ++i) {
+        auto center = Math::Point(20.0 + (i % 10) * 50, 20.0 + (i / 10) * 50);
+        shapes.push_back(Math::RegularPolygon(center, 15, i * 7, 5));
+    }
+    shapes.push_back(Math::Rectangle({0, 0}, 10, 20));
+
+    auto svg = Sketch::joinInstances(shapes, "Tile");
+    assert(svg.starts_with("<defs>\n<path id=\"g0\" d=\"M"));
+    assert(svg.find("id=\"g1\"") == std::string::npos);
+    assert(std::count(svg.begin(), svg.end(), '#') > 50);
+    assert(svg.find("<path\nid=\"Tile\"") != std::string::npos);   // Unique shape.
+    assert(svg.size() < Sketch::join(shapes, "Tile").size());
+
+    // Transforms reproduce the shapes.
+    auto begin = svg.find(" d=\"") + 4;
+    auto geometry = parsePath(svg.substr(begin, svg.find('"', begin) - begin));
+    size_t position = 0;
+    for (size_t i = 0; i < 50; ++i) {
+        position = svg.find("matrix(", position) + 7;
+        std::array<double, 6> m{};
+        std::istringstream values(svg.substr(position, svg.find(')', position) - position));
+        for (auto &value : m) {
+            values >> value;
+        }
+        auto points = shapes[i].pointsXY();
+        assert(points.size() == geometry.size());
+        for (size_t k = 0; k < points.size(); ++k) {
+            auto x = m[0] * geometry[k][0] + m[2] * geometry[k][1] + m[4];
+            auto y = m[1] * geometry[k][0] + m[3] * geometry[k][1] + m[5];
+            assert(std::abs(x - points[k][0]) < 1e-4 && std::abs(y - points[k][1]) < 1e-4);
+        }
+    }
+
+    // Nothing repeated : plain polygons.
+    assert(Sketch::joinInstances({Math::Rectangle({0, 0}, 10, 20)}, "R") == Sketch::join({Math::Rectangle({0, 0}, 10, 20)}, "R"));
+}
+
+void clones()
+{
+    using namespace stbox;
+
+    // Same output as clone.
+    std::vector<Image::SVG::CloneShape> items;
+    for (int i = 0; i < 100; ++i) {
+        items.push_back({i * 3.7, {-50.0 + i, 0}, {180, 180.0 + i}});
+    }
+    auto first = Image::SVG::cloneCounter.load();
+    auto batch = Image::SVG::clones("Particle", items);
+    Image::SVG::cloneCounter = first;
+    std::string single;
+    for (const auto &item : items) {
+        single += Image::SVG::clone("Particle", item.rotationAngle, item.center, item.position) + "\n";
+    }
+    assert(batch == single);
+
+    // Unique IDs across threads.
+    std::vector<std::string> results(4);
+    std::vector<std::thread> threads;
+    for (auto &result : results) {
+        threads.emplace_back([&result, &items]() {
+            for (int i = 0; i < 10; ++i) {
+                result += Image::SVG::clones("P", items);
+                result += Image::SVG::clone("P", 0, {0, 0}, {0, 0}) + "\n";
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    std::set<std::string> ids;
+    size_t count = 0;
+    for (const auto &result : results) {
+        for (size_t position = result.find("id=\""); position != std::string::npos; position = result.find("id=\"", position + 1)) {
+            ids.insert(result.substr(position, result.find('"', position + 4) - position));
+            ++count;
+        }
+    }
+    assert(count == 4 * 10 * 101);
+    assert(ids.size() == count);
+}
+
+void document()
+{
+    using namespace stbox;
+
+    Image::SVG::Metadata metadata;
+    metadata.date = "2000";
+    Image::Document document(600, 600, metadata);
+
+    // Groups of polygons, a circle and raw XML.
+    std::vector<Image::Document::Id> groups;
+    std::vector<Image::Document::Id> ids;
+    std::vector<Image::SVG::NormalShape> shapes;
+    for (int g = 0; g < 10; ++g) {
+        groups.push_back(document.group("Group" + std::to_string(g)));
+        for (int i = 0; i < 100; ++i) {
+            shapes.push_back(Sketch::normalShape(Math::RegularPolygon({g * 50.0, i * 5.0}, 4, i, 3 + i % 4), "P"));
+            ids.push_back(document.polygon(shapes.back(), groups.back()));
+        }
+    }
+    Image::SVG::CircleShape circleShape("C", "#FF0000", "#000000", 1, {50, 50}, 10, 10);
+    auto circle = document.circle(circleShape);
+    auto comment = document.raw("<!-- Comment -->\n");
+
+    auto expected = [&]() {
+        std::string xml;
+        for (int g = 0; g < 10; ++g) {
+            std::string elements;
+            for (int i = 0; i < 100; ++i) {
+                if (document.valid(ids[g * 100 + i])) {
+                    elements += Image::SVG::polygon(shapes[g * 100 + i]);
+                }
+            }
+            xml += Image::SVG::group("Group" + std::to_string(g), elements);
+        }
+        xml += Image::SVG::circle(circleShape);
+        xml += document.valid(comment) ? document.text(comment) : "";
+        return Image::SVG::svg(600, 600, xml, metadata);
+    };
+
+    assert(document.svg() == expected());
+    assert(document.serializations() == 1001);
+
+    // Only the changed elements are serialized again.
+    auto serialized = document.serialized();
+    shapes[150].fill = "#00FF00";
+    assert(document.update(ids[150], shapes[150]) == true);
+    circleShape.horizontalRadius = 20;
+    assert(document.update(circle, circleShape) == true);
+    assert(document.svg() == expected());
+    assert(document.serializations() == 1003);
+    assert(document.svg() == expected());
+    assert(document.serializations() == 1003);
+
+    // Byte cost of the edit : the two elements, the groups are not rebuilt.
+    auto cost = Image::SVG::polygon(shapes[150]).size() + Image::SVG::circle(circleShape).size();
+    assert(document.serialized() == serialized + cost);
+    size_t pieces = 0;
+    std::string body;
+    document.pieces([&](const std::string &piece) {
+        ++pieces;
+        body += piece;
+    });
+    assert(pieces == 10 * (100 + 2) + 2);
+    assert(Image::SVG::header(600, 600, metadata) + body + Image::SVG::footer() == expected());
+    assert(document.serialized() == serialized + cost);
+
+    // Renamed group : only its tag.
+    assert(document.update(groups[1], std::string("Group1")) == true);
+    assert(document.svg() == expected());
+    assert(document.serialized() == serialized + cost + std::string("<g id=\"Group1\" >\n").size());
+
+    // Kind mismatch.
+    assert(document.update(circle, shapes[0]) == false);
+    assert(document.update(ids[0], circleShape) == false);
+
+    // Removal : element and group, stable IDs.
+    assert(document.remove(ids[0]) == true);
+    assert(document.remove(ids[0]) == false);
+    assert(document.remove(groups[9]) == true);
+    assert(document.valid(ids[950]) == false);
+    assert(document.remove(comment) == true);
+    auto svg = document.svg();
+    assert(svg.find("Group9") == std::string::npos);
+    assert(document.serializations() == 1003);
+    assert(document.valid(ids[1]) == true && document.bytes(ids[1]) == Image::SVG::polygon(shapes[1]));
+
+    // Nested groups and streaming.
+    auto inner = document.group("Inner", groups[0]);
+    document.polyline(shapes[2], inner);
+    assert(document.parent(inner) == groups[0]);
+    assert(document.bytes(groups[0]).find("<g id=\"Inner\" >\n<polyline") != std::string::npos);
+    std::ostringstream stream;
+    document.write(stream);
+    assert(stream.str() == document.svg());
+
+    // One format for the whole output, the cache is serialized again when it changes.
+    Image::SVG::NormalShape first("A", "none", "#000000", 1, {{1.123456789, 2}, {3, 4}, {5, 2}});
+    Image::SVG::NormalShape second("B", "none", "#000000", 1, {{2.987654321, 2}, {3, 4}, {5, 2}});
+    Image::Document formatted(100, 100, metadata);
+    formatted.polygon(first);
+    assert(formatted.svg().find("M 1.123457 2") != std::string::npos);
+    const Image::SVG::Format format{2, true, false};
+    formatted.format(format);
+    formatted.polygon(second);
+    svg = formatted.svg();
+    assert(svg.find("1.123457") == std::string::npos);
+    assert(svg == Image::SVG::svg(100, 100, Image::SVG::polygon(first, format) + Image::SVG::polygon(second, format), metadata));
+    assert(formatted.serializations() == 3);
+    formatted.format(format);
+    assert(formatted.svg() == svg);
+    assert(formatted.serializations() == 3);
+    Image::Document constructed(100, 100, metadata, format);
+    constructed.polygon(first);
+    constructed.polygon(second);
+    assert(constructed.svg() == svg);
+}
+
+void patch()
+{
+    using namespace stbox;
+
+    Image::SVG::Metadata metadata;
+    metadata.date = "2000";
+    Image::Document before(600, 600, metadata);
+    std::vector<Image::Document::Id> ids;
+    std::vector<Image::SVG::NormalShape> shapes;
+    auto group = before.group("Group");
+    for (int i = 0; i < 50; ++i) {
+        shapes.push_back(Sketch::normalShape(Math::RegularPolygon({i * 10.0, 100}, 4, i, 3 + i % 4), "P"));
+        ids.push_back(before.polygon(shapes.back(), i < 25 ? group : Image::Document::root));
+    }
+    auto inner = before.group("Inner", group);
+    before.polyline(shapes[0], inner);
+
+    // No change.
+    auto after = before;
+    assert(Image::Document::diff(before, after).empty());
+
+    // Edits : changed, removed (element and group), added, renamed.
+    shapes[30].fill = "#00FF00";
+    after.update(ids[30], shapes[30]);
+    after.remove(ids[40]);
+    after.remove(inner);
+    auto circle = after.circle(Image::SVG::CircleShape("C", "#FF0000", "#000000", 1, {50, 50}, 10, 10), group);
+    auto added = after.group("Added");
+    after.raw("<!-- Comment -->\n", added);
+    after.update(group, std::string("Renamed"));
+
+    auto changes = Image::Document::diff(before, after);
+    assert(changes.size() == 7);
+    assert(changes[0].op == Image::Document::Change::REMOVE && changes[0].id == ids[40]);
+    assert(changes[1].op == Image::Document::Change::REMOVE && changes[1].id == inner);
+    assert(changes[2].op == Image::Document::Change::CHANGE && changes[2].id == group && changes[2].text == "Renamed");
+    assert(changes[3].op == Image::Document::Change::CHANGE && changes[3].id == ids[30]);
+    assert(changes[3].text == Image::SVG::polygon(shapes[30]));
+    assert(changes[4].op == Image::Document::Change::ADD && changes[4].id == circle && changes[4].parent == group);
+    assert(changes[5].op == Image::Document::Change::ADD && changes[5].id == added && changes[5].group);
+    assert(changes[6].op == Image::Document::Change::ADD && changes[6].parent == added && changes[6].text == "<!-- Comment -->\n");
+
+    // The patch is smaller than the document.
+    auto text = Image::Document::patch(changes);
+    assert(text.find("<remove id=\"" + std::to_string(ids[40]) + "\" />") != std::string::npos);
+    assert(text.find("<rename id=\"" + std::to_string(group) + "\" name=\"Renamed\" />") != std::string::npos);
+    assert(text.size() < after.svg().size() / 4);
+
+    // Round trip : same IDs, same output.
+    auto copy = before;
+    copy.apply(changes);
+    assert(copy.svg() == after.svg());
+    assert(copy.valid(circle) && copy.parent(circle) == group);
+    assert(Image::Document::diff(copy, after).empty());
+
+    // From an empty document, the whole scene.
+    Image::Document empty(600, 600, metadata);
+    Image::Document scene(600, 600, metadata);
+    scene.apply(Image::Document::diff(empty, after));
+    assert(scene.svg() == after.svg());
+
+    // Escaped names.
+    auto renamed = after;
+    renamed.update(group, std::string("a\"b<c>&'d"));
+    text = Image::Document::patch(Image::Document::diff(after, renamed));
+    assert(text.find("name=\"a&quot;b&lt;c&gt;&amp;&apos;d\"") != std::string::npos);
+
+    // Elements replaced (parent or kind changed) keep their place among the siblings.
+    Image::Document first(600, 600, metadata);
+    Image::Document second(600, 600, metadata);
+    auto outer = first.group("Outer");
+    second.group("Outer");
+    for (int i = 0; i < 4; ++i) {
+        first.polygon(shapes[i]);
+    }
+    second.polygon(shapes[0], outer);
+    second.polygon(shapes[1]);
+    second.group("Kind");
+    second.polygon(shapes[3]);
+    second.polygon(shapes[4], outer);
+    changes = Image::Document::diff(first, second);
+    assert(changes.back().op == Image::Document::Change::ADD && changes.back().group && changes.back().position == 2);
+    copy = first;
+    copy.apply(changes);
+    assert(copy.svg() == second.svg());
+    assert(copy.children(Image::Document::root) == second.children(Image::Document::root));
+    assert(copy.children(outer) == second.children(outer));
+
+    // Added over a live element : replaced, not duplicated. The root is never replaced.
+    copy = before;
+    Image::Document::Change change;
+    change.id = ids[1];
+    change.parent = group;
+    change.text = "<!-- Replaced -->\n";
+    change.position = 1;
+    copy.apply({change});
+    assert(copy.children(group) == before.children(group));
+    assert(copy.bytes(ids[1]) == "<!-- Replaced -->\n");
+    change.id = Image::Document::root;
+    copy.apply({change});
+    assert(copy.valid(Image::Document::root) && copy.children(group) == before.children(group));
+}
+
+void parallel()
+{
+    using namespace stbox;
+
+    std::vector<Math::Base> bases;
+    for (int i = 0; i < 5000; ++i) {
+        bases.push_back(Math::RegularPolygon({i % 100 * 6.0, i / 100 * 6.0}, 3, i, 3 + i % 5));
+    }
+
+    // Same bytes for any number of threads and chunks.
+    auto sequential = Sketch::join(bases, "P");
+    for (unsigned threads : {0U, 1U, 2U, 3U, 7U, 64U}) {
+        assert(Sketch::joinParallel(bases, "P", threads) == sequential);
+    }
+    assert(Sketch::joinParallel({}, "P", 4).empty());
+
+    // Elements in order.
+    auto text = Image::SVG::elements(1000, [](size_t i, std::string &elements) {
+        elements += std::to_string(i) + ",";
+    }, 5);
+    std::string expected;
+    for (int i = 0; i < 1000; ++i) {
+        expected += std::to_string(i) + ",";
+    }
+    assert(text == expected);
+
+    // The threads use the format captured by the element.
+    const Image::SVG::Format format{2, true, false};
+    text = Image::SVG::elements(1000, [&format](size_t, std::string &elements) {
+        Image::SVG::number(elements, 1.23456, format);
+        elements += ' ';
+    }, 4);
+    expected.clear();
+    for (int i = 0; i < 1000; ++i) {
+        expected += "1.23 ";
+    }
+    assert(text == expected);
+}
+
 void interpreter()
 {
     using namespace stbox;
@@ -131,6 +850,11 @@ void loadTxt()
     std::string errors;
     auto svg = interpreter.load("Resources/svg_commands.txt", errors);
 
+    // Parallel conversion, same output.
+    std::string parallelErrors;
+    assert(interpreter.load("Resources/svg_commands.txt", parallelErrors, 4) == svg);
+    assert(parallelErrors == errors);
+
     svg = Sketch::svg(100, 100, svg, Sketch::Metadata());
     Sys::IO::save(svg, "Resources/svgOutput2.svg");
 